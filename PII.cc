@@ -3,59 +3,142 @@
 
 #include "PIIDetectorConstruction.hh"
 #include "PIIActionInitialization.hh"
-#include "PIISteppingAction.hh"
-#include "PIIEventAction.hh"
+#include "PIIRunAction.hh"
+#include "PIISweep.hh"
+#include "PIIOpticalPhysicsList.hh"
 
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
+#include "G4Threading.hh"
 #else
 #include "G4RunManager.hh"
 #endif
 
 #include "G4String.hh"
+#include "G4Run.hh"
 #include "G4OpticalPhysics.hh"
+#include "G4FastSimulationPhysics.hh"
+#include "G4HadronicParameters.hh"
 #include "G4EmStandardPhysics_option4.hh"
 
 #include "G4UImanager.hh"
+#include "G4UIcommand.hh"
 #include "FTFP_BERT.hh"
 #include "G4StepLimiterPhysics.hh"
 
 #include "Randomize.hh"
 
+// Built without vis drivers (WITH_GEANT4_UIVIS=OFF), PII is always headless
+#ifdef PII_WITH_VIS
 #include "G4VisExecutive.hh"
+#endif
 #include "G4UIExecutive.hh"
 
+#include <chrono>
+#include <fstream>
+#include <sys/resource.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  // Throughput metrics of one run, written as a single JSON object
+  void WriteBenchmark(const G4String& fileName, G4int nThreads,
+                      G4double startup, G4double runTime,
+                      G4int nEvents, G4long nSteps)
+  {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::ofstream out(fileName);
+    out << "{\"threads\": " << nThreads
+        << ", \"events\": " << nEvents
+        << ", \"startup_s\": " << startup
+        << ", \"run_s\": " << runTime
+        << ", \"events_per_s\": " << (runTime > 0. ? nEvents/runTime : 0.)
+        << ", \"optical_steps\": " << nSteps
+        << ", \"optical_steps_per_s\": " << (runTime > 0. ? nSteps/runTime : 0.)
+        << ", \"peak_rss_kb\": " << usage.ru_maxrss
+        << "}" << std::endl;
+  }
+
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 int main(int argc, char** argv)
 {
-  // Detect interactive mode (if no arguments) and define UI session
+  auto startTime = std::chrono::steady_clock::now();
+
+  // Detect interactive mode (if no macro argument) and define UI session
   //
+  G4String macro = "";
+  G4int firstOption = 1;
+  if ( argc > 1 && argv[1][0] != '-' ) {
+    macro = argv[1];
+    firstOption = 2;
+  }
+
   G4UIExecutive* ui = 0;
-  if ( argc == 1 ) {
+  if ( macro == "" ) {
     ui = new G4UIExecutive(argc, argv);
   }
 
+  // Headless: no vis manager, no trajectory models and no stored trajectories.
+  // Batch runs are always headless, interactive ones with --no-vis.
+  G4bool headless = ( ! ui );
+
   G4cout << "You have entered " << argc << " arguments:" << "\n";
 
   for (int i = 0; i < argc; ++i)
       G4cout << argv[i] << "\n";
 
+  G4String cmdlineEvents = "";
+  G4String output = "";
+  G4String runid = "";
+  G4int nThreads = 1;
+  G4String benchFile = "";
+  G4String sweepFile = "";
+  G4String eventOffset = "";
+  G4String physics = "full";
+
+  for(G4int i = firstOption; i < argc; ++i) {
+          if(G4String(argv[i]) == "-n" && i+1 < argc)
+            cmdlineEvents = G4String(argv[++i]);
+          else if(G4String(argv[i]) == "-o" && i+1 < argc)
+            output = G4String(argv[++i]);
+          else if(G4String(argv[i]) == "-r" && i+1 < argc)
+            runid = G4String(argv[++i]);
+          else if(G4String(argv[i]) == "-t" && i+1 < argc)
+            nThreads = G4UIcommand::ConvertToInt(argv[++i]);
+          else if(G4String(argv[i]) == "-e" && i+1 < argc)
+            eventOffset = G4String(argv[++i]);
+          else if(G4String(argv[i]) == "--physics" && i+1 < argc)
+            physics = G4String(argv[++i]);
+          else if(G4String(argv[i]) == "--bench" && i+1 < argc)
+            benchFile = G4String(argv[++i]);
+          else if(G4String(argv[i]) == "--sweep" && i+1 < argc)
+            sweepFile = G4String(argv[++i]);
+          else if(G4String(argv[i]) == "--no-vis")
+            headless = true;
+          }
+
   // Optionally: choose a different Random engine...
   // G4Random::setTheEngine(new CLHEP::MTwistEngine);
 
   // Construct the default run manager
+  // -t 0 uses every core on the node
   //
-/* #ifdef G4MULTITHREADED
+#ifdef G4MULTITHREADED
   G4MTRunManager* runManager = new G4MTRunManager;
-  //G4int nThreads = std::min(G4Threading::G4GetNumberOfCores(), 6);
-  runManager->SetNumberOfThreads(1);
+  if (nThreads <= 0) nThreads = G4Threading::G4GetNumberOfCores();
+  runManager->SetNumberOfThreads(nThreads);
   G4cout << "===== PII is started with "
          <<  runManager->GetNumberOfThreads() << " threads =====" << G4endl;
-*/
-//#else
+#else
   G4RunManager* runManager = new G4RunManager;
-//#endif
+  nThreads = 1;
+#endif
 
   // Set mandatory initialization classes
   // Detector construction
@@ -63,42 +146,62 @@ int main(int argc, char** argv)
   runManager->SetUserInitialization(detector);
 
   // Physics List
-  G4VModularPhysicsList* physicsList = new FTFP_BERT;
-  physicsList->SetVerboseLevel(0);
-  G4OpticalPhysics* opticalPhysics = new G4OpticalPhysics();
-  physicsList->RegisterPhysics(opticalPhysics);
+  // --physics optical: transportation, standard EM and optical processes, for
+  // runs with optical photon primaries. The full list is needed for charged ones.
+  // The macros run with both, so they leave out the /process/had/ commands the
+  // optical list does not define; hadronic verbosity is set here instead.
+  G4VModularPhysicsList* physicsList = nullptr;
+
+  if (physics == "optical") {
+    physicsList = new PIIOpticalPhysicsList();
+  }
+  else {
+    if (physics != "full") {
+      G4cout << "Unknown physics list " << physics << ", using full" << G4endl;
+    }
+    physicsList = new FTFP_BERT;
+    physicsList->SetVerboseLevel(0);
+    G4HadronicParameters::Instance()->SetVerboseLevel(0);
+    G4OpticalPhysics* opticalPhysics = new G4OpticalPhysics();
+    physicsList->RegisterPhysics(opticalPhysics);
+  }
+
+  // Fast simulation hook for the scintillator transport model
+  G4FastSimulationPhysics* fastSimulationPhysics = new G4FastSimulationPhysics();
+  fastSimulationPhysics->ActivateFastSimulation("opticalphoton");
+  physicsList->RegisterPhysics(fastSimulationPhysics);
   runManager->SetUserInitialization(physicsList);
 
-  // Set user action classes
-  auto eventAction = new PIIEventAction(detector);
-  auto stepAction = new PIISteppingAction(detector, eventAction);
-  runManager->SetUserInitialization(new PIIActionInitialization(detector, eventAction, stepAction));
+  // Set user action classes, built per worker thread
+  runManager->SetUserInitialization(new PIIActionInitialization(detector));
 
-  // Initialize visualization
-  //
-  G4VisManager* visManager = new G4VisExecutive;
-  // G4VisExecutive can take a verbosity argument - see /vis/verbose guidance.
-  // G4VisManager* visManager = new G4VisExecutive("Quiet");
-  visManager->Initialize();
+  // Parameter sweeps, /PII/sweep/run
+  PIISweep* sweep = new PIISweep();
 
   // Get the pointer to the User Interface manager
   G4UImanager* UImanager = G4UImanager::GetUIpointer();
 
-  // Process macro or start UI session
+  // Initialize visualization
   //
+#ifdef PII_WITH_VIS
+  G4VisManager* visManager = 0;
+  if ( ! headless ) {
+    visManager = new G4VisExecutive;
+    // G4VisExecutive can take a verbosity argument - see /vis/verbose guidance.
+    // G4VisManager* visManager = new G4VisExecutive("Quiet");
+    visManager->Initialize();
+  }
+#else
+  headless = true;
+#endif
 
-  G4String cmdlineEvents = "";
-  G4String output = "";
-  G4String runid = "";
+  // Nothing draws trajectories without vis, so events do not keep them
+  if ( headless ) {
+    UImanager->ApplyCommand("/tracking/storeTrajectory 0");
+  }
 
-  for(G4int i = 2; i < argc; ++i) {
-          if(G4String(argv[i]) == "-n" && i+1 < argc)
-            cmdlineEvents = G4String(argv[++i]);
-          else if(G4String(argv[i]) == "-o" && i+1 < argc)
-            output = G4String(argv[++i]);
-          else if(G4String(argv[i]) == "-r" && i+1 < argc)
-            runid = G4String(argv[++i]);
-          }
+  // Process macro or start UI session
+  //
 
   G4cout << "The number of events: " << cmdlineEvents << G4endl;
   G4cout << "The file output name: " << output << G4endl;
@@ -107,12 +210,13 @@ int main(int argc, char** argv)
   if ( ! ui ) {
     // batch mode
     G4String command = "/control/execute ";
-    G4String fileName = argv[1];
-    UImanager->ApplyCommand(command+fileName);
+    UImanager->ApplyCommand(command+macro);
   }
   else {
-    // interactive mode
-    UImanager->ApplyCommand("/control/execute init_vis.mac");
+    // interactive mode, init.mac initializes the kernel and init_vis.mac
+    // runs it before setting up the viewer
+    if ( headless ) UImanager->ApplyCommand("/control/execute init.mac");
+    else UImanager->ApplyCommand("/control/execute init_vis.mac");
     ui->SessionStart();
     delete ui;
   }
@@ -120,14 +224,45 @@ int main(int argc, char** argv)
   UImanager->ApplyCommand("/PII/output/runid " + runid);
   UImanager->ApplyCommand("/PII/output/filename " + output);
   UImanager->ApplyCommand("/random/setSeeds " + runid + " " + cmdlineEvents);
-  UImanager->ApplyCommand("/run/beamOn " + cmdlineEvents);
+
+  // Events are seeded from the run id and their event number, so results do
+  // not depend on the event count or the number of threads
+  if (runid != "") UImanager->ApplyCommand("/PII/random/runSeed " + runid);
+  // -e: global number of the first event, set by PII_shards for each shard
+  if (eventOffset != "") UImanager->ApplyCommand("/PII/random/eventOffset " + eventOffset);
+
+  auto runStart = std::chrono::steady_clock::now();
+  // --sweep: one run per point of the sweep file, -n events each
+  if (sweepFile != "") {
+    if (cmdlineEvents != "") UImanager->ApplyCommand("/PII/sweep/events " + cmdlineEvents);
+    UImanager->ApplyCommand("/PII/sweep/run " + sweepFile);
+  }
+  else {
+    UImanager->ApplyCommand("/run/beamOn " + cmdlineEvents);
+  }
+  auto runEnd = std::chrono::steady_clock::now();
+
+  // --bench: startup and event loop timing, step rate and memory as JSON
+  if (benchFile != "" && runManager->GetCurrentRun()) {
+    const PIIRunAction* runAction
+      = static_cast<const PIIRunAction*>(runManager->GetUserRunAction());
+
+    WriteBenchmark(benchFile, nThreads,
+                   std::chrono::duration<G4double>(runStart - startTime).count(),
+                   std::chrono::duration<G4double>(runEnd - runStart).count(),
+                   runManager->GetCurrentRun()->GetNumberOfEvent(),
+                   runAction->GetNoSteps());
+  }
 
   // Job termination
   // Free the store: user actions, physics_list and detector_description are
   // owned and deleted by the run manager, so they should not be deleted
   // in the main() program !
   //
+#ifdef PII_WITH_VIS
   delete visManager;
+#endif
+  delete sweep;
   delete runManager;
 }
 
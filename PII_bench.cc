@@ -0,0 +1,204 @@
+/// \file PII_bench.cc
+/// \brief Benchmark driver running PII over a fixed matrix of workloads
+
+// Usage: PII_bench [-x PII executable] [-n events] [-t threads] [-o results]
+//
+// Each workload runs in a fresh directory with a fixed seed through
+// "PII bench.mac --bench metrics.json". The metrics of every run, plus the
+// bytes of output it wrote, are collected into one JSON document.
+//
+// Every workload runs on each geometry build: one placement per volume,
+// replicated arrays (/PII/det/replicate) and primitive solids
+// (/PII/det/primitiveSolids), so startup_s, peak_rss_kb and
+// optical_steps_per_s compare them.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  struct Workload
+  {
+    int distribution; // /PII/generator/distribution
+    int outputs;      // /PII/output/files
+    int rows;         // /PII/det/rowNumber
+    int cols;         // /PII/det/colNumber
+    int geometry;     // index in kGeometries
+  };
+
+  struct Geometry
+  {
+    const char* name;
+    const char* commands;
+  };
+
+  const Geometry kGeometries[] = {
+    { "placed",     "" },
+    { "replicated", "/PII/det/replicate 1\n" },
+    { "primitive",  "/PII/det/primitiveSolids 1\n" }
+  };
+  const int kNbOfGeometries = sizeof(kGeometries)/sizeof(kGeometries[0]);
+
+  // Seeds are passed as the run id, so every workload is reproducible
+  const char* kSeed = "20200101";
+
+  std::string Name(const Workload& w)
+  {
+    std::ostringstream name;
+    name << "dist" << w.distribution << "_out" << w.outputs
+         << "_" << w.rows << "x" << w.cols << "_" << kGeometries[w.geometry].name;
+    return name.str();
+  }
+
+  void WriteMacro(const std::string& path, const Workload& w)
+  {
+    std::ofstream mac(path);
+    mac << "/control/verbose 0\n"
+        << "/run/verbose 0\n"
+        << "/process/em/verbose 0\n"
+        << "/PII/det/rowNumber " << w.rows << "\n"
+        << "/PII/det/colNumber " << w.cols << "\n"
+        << kGeometries[w.geometry].commands
+        << "/run/initialize\n"
+        << "/PII/generator/distribution " << w.distribution << "\n"
+        << "/PII/output/files " << w.outputs << "\n";
+  }
+
+  // Bytes in the files a run left in its directory, apart from our own
+  long long OutputBytes(const std::string& dir)
+  {
+    long long bytes = 0;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return 0;
+
+    while (struct dirent* entry = readdir(d)) {
+      std::string file = entry->d_name;
+      if (file == "bench.mac" || file == "metrics.json" || file == "PII.log")
+        continue;
+
+      struct stat st;
+      if (stat((dir + "/" + file).c_str(), &st) == 0 && S_ISREG(st.st_mode))
+        bytes += st.st_size;
+    }
+    closedir(d);
+
+    return bytes;
+  }
+
+  std::string ReadMetrics(const std::string& path)
+  {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  std::string executable = "./PII";
+  std::string events = "10000";
+  std::string threads = "1";
+  std::string results = "";
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-x" && i+1 < argc) executable = argv[++i];
+    else if (arg == "-n" && i+1 < argc) events = argv[++i];
+    else if (arg == "-t" && i+1 < argc) threads = argv[++i];
+    else if (arg == "-o" && i+1 < argc) results = argv[++i];
+    else {
+      std::cerr << "Usage: " << argv[0]
+                << " [-x PII] [-n events] [-t threads] [-o results.json]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // Runs change directory, so the executable needs an absolute path
+  char resolved[PATH_MAX];
+  if (!realpath(executable.c_str(), resolved)) {
+    std::cerr << "PII_bench: cannot find " << executable << std::endl;
+    return 1;
+  }
+  executable = resolved;
+
+  // Fixed matrix: every distribution and ntuple output mode on the
+  // default 3x3 array and on a full-size 14x11 array, for every geometry
+  std::vector<Workload> matrix;
+  const int arrays[2][2] = { {3, 3}, {14, 11} };
+
+  for (int a = 0; a < 2; a++) {
+    for (int geometry = 0; geometry < kNbOfGeometries; geometry++) {
+      for (int distribution = 1; distribution <= 3; distribution++) {
+        for (int outputs = 1; outputs <= 3; outputs++) {
+          Workload w = { distribution, outputs, arrays[a][0], arrays[a][1], geometry };
+          matrix.push_back(w);
+        }
+      }
+    }
+  }
+
+  std::ostringstream json;
+  json << "{\"events\": " << events << ", \"threads\": " << threads
+       << ", \"seed\": " << kSeed << ", \"workloads\": [";
+
+  int failures = 0;
+
+  for (size_t k = 0; k < matrix.size(); k++) {
+    const Workload& w = matrix[k];
+    std::string dir = "bench_" + Name(w);
+
+    std::system(("rm -rf " + dir).c_str());
+    mkdir(dir.c_str(), 0755);
+    WriteMacro(dir + "/bench.mac", w);
+
+    std::cerr << "PII_bench: " << Name(w) << std::endl;
+
+    std::string command = "cd " + dir + " && \"" + executable + "\" bench.mac"
+                        + " -n " + events + " -t " + threads + " -r " + kSeed
+                        + " --bench metrics.json > PII.log 2>&1";
+    int status = std::system(command.c_str());
+
+    std::string metrics = ReadMetrics(dir + "/metrics.json");
+
+    json << (k ? "," : "") << "\n  {\"name\": \"" << Name(w) << "\""
+         << ", \"distribution\": " << w.distribution
+         << ", \"outputs\": " << w.outputs
+         << ", \"rows\": " << w.rows << ", \"cols\": " << w.cols
+         << ", \"geometry\": \"" << kGeometries[w.geometry].name << "\""
+         << ", \"status\": " << status
+         << ", \"bytes_written\": " << OutputBytes(dir)
+         << ", \"metrics\": " << (metrics != "" ? metrics : "null") << "}";
+
+    if (status != 0 || metrics == "") failures++;
+  }
+
+  json << "\n]}\n";
+
+  if (results != "") {
+    std::ofstream out(results);
+    out << json.str();
+  }
+  else {
+    std::cout << json.str();
+  }
+
+  return failures ? 1 : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
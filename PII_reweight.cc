@@ -0,0 +1,265 @@
+/// \file PII_reweight.cc
+/// \brief Reweights PII photon ntuples to other optical parameters
+
+// Usage:
+//   PII_reweight [-v name:key=value,...]... [--nominal key=value,...]
+//                <photon ntuple csv> [<photon ntuple csv> ...]
+//
+// Keys: reflector, guide and tab are the REFLECTIVITY of surfOpt, surfLightG
+// and tabMatSurf, abs is the ABSLENGTH of ScintMat in cm. The nominal values
+// are those of PIIDetectorConstruction: 1.0, 0.995, 0.95 and 145 cm.
+//
+// The ntuples must have been written with /PII/output/pathSummary, which adds
+// the path length in the scintillator and the reflections off each of the
+// three skins of every photon. A detected photon that reflected n times off
+// a skin of reflectivity R and travelled L in the scintillator then counts
+// with weight
+//   (R'/R)^n ... * exp(-L/abs' + L/abs)
+// in a variation, the ratio of the probabilities of its path with the new
+// and the nominal values. The sum of weights over the detected photons of
+// one nominal run estimates the detection efficiency of every variation,
+// without tracking again. Reflectivities above the nominal one are fine as
+// long as the nominal one is not zero.
+//
+// Ntuples of biased runs (/PII/bias/) have a Weight column, which multiplies
+// the weight of each photon. The copies of a split photon follow it with the
+// same photon number and count as one photon.
+//
+// Every variation, the nominal one first, is written as one CSV line with
+// its efficiency, statistical error and weighted hits per PMT.
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  struct Variation
+  {
+    std::string name;
+    double      reflector;
+    double      guide;
+    double      tab;
+    double      absLength;
+  };
+
+  struct Tally
+  {
+    double              sumW;
+    double              sumW2;
+    std::vector<double> pmtW;
+  };
+
+  // Nominal optical parameters, lengths in the units of the ntuples (mm)
+  const Variation kNominal = { "nominal", 1.0, 0.995, 0.95, 1450. };
+
+  // Applies "key=value,key=value" to a variation
+  bool Parse(const std::string& spec, Variation& v)
+  {
+    std::stringstream fields(spec);
+    std::string field;
+
+    while (std::getline(fields, field, ',')) {
+      size_t eq = field.find('=');
+      if (eq == std::string::npos) return false;
+      std::string key = field.substr(0, eq);
+      double value = std::atof(field.substr(eq + 1).c_str());
+
+      if (key == "reflector") v.reflector = value;
+      else if (key == "guide") v.guide = value;
+      else if (key == "tab") v.tab = value;
+      else if (key == "abs") v.absLength = value * 10.; // cm to mm
+      else return false;
+    }
+    return true;
+  }
+
+  // Column index by name from the "#column <type> <name>" header lines
+  int FindColumn(const std::vector<std::string>& columns, const std::string& name)
+  {
+    for (size_t c = 0; c < columns.size(); c++) {
+      if (columns[c] == name) return c;
+    }
+    return -1;
+  }
+
+  int Usage(const char* name)
+  {
+    std::cerr << "Usage: " << name << " [-v name:key=value,...]..."
+              << " [--nominal key=value,...] <photon ntuple csv>...\n"
+              << "       keys: reflector, guide, tab (reflectivity), abs (cm)"
+              << std::endl;
+    return 1;
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  Variation nominal = kNominal;
+  std::vector<std::string> specs;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-v" && i+1 < argc) specs.push_back(argv[++i]);
+    else if (arg == "--nominal" && i+1 < argc) {
+      if (!Parse(argv[++i], nominal)) return Usage(argv[0]);
+    }
+    else if (arg[0] == '-') return Usage(argv[0]);
+    else files.push_back(arg);
+  }
+
+  if (files.empty()) return Usage(argv[0]);
+
+  if (nominal.reflector <= 0. || nominal.guide <= 0. || nominal.tab <= 0.
+      || nominal.absLength <= 0.) {
+    std::cerr << "PII_reweight: nominal values must be positive" << std::endl;
+    return 1;
+  }
+
+  // The nominal run itself comes first, then every -v variation
+  std::vector<Variation> variations(1, nominal);
+
+  for (size_t s = 0; s < specs.size(); s++) {
+    size_t colon = specs[s].find(':');
+    Variation v = nominal;
+    v.name = specs[s].substr(0, colon);
+    if (colon == std::string::npos || !Parse(specs[s].substr(colon + 1), v)
+        || v.absLength <= 0.) {
+      return Usage(argv[0]);
+    }
+    variations.push_back(v);
+  }
+
+  const size_t nVariations = variations.size();
+  std::vector<Tally> tallies(nVariations);
+  for (size_t u = 0; u < nVariations; u++) {
+    tallies[u].sumW = 0.;
+    tallies[u].sumW2 = 0.;
+  }
+
+  // Per photon weight factors of each variation
+  std::vector<double> reflectorRatio(nVariations), guideRatio(nVariations);
+  std::vector<double> tabRatio(nVariations), inverseAbs(nVariations);
+  for (size_t u = 0; u < nVariations; u++) {
+    reflectorRatio[u] = variations[u].reflector / nominal.reflector;
+    guideRatio[u] = variations[u].guide / nominal.guide;
+    tabRatio[u] = variations[u].tab / nominal.tab;
+    inverseAbs[u] = 1./variations[u].absLength - 1./nominal.absLength;
+  }
+
+  long long nPhotons = 0;
+
+  for (size_t f = 0; f < files.size(); f++) {
+    std::ifstream in(files[f]);
+    if (!in) {
+      std::cerr << "PII_reweight: cannot open " << files[f] << std::endl;
+      return 1;
+    }
+
+    std::vector<std::string> columns;
+    int path = -1, reflector = -1, guide = -1, tab = -1, weight = -1;
+    double lastPhoton = -1.;
+    std::string line;
+
+    while (std::getline(in, line)) {
+      if (line.empty()) continue;
+
+      if (line[0] == '#') {
+        // "#column double Scint path"
+        if (line.compare(0, 8, "#column ") == 0) {
+          size_t name = line.find(' ', 8);
+          columns.push_back(name != std::string::npos ? line.substr(name + 1) : "");
+        }
+        continue;
+      }
+
+      if (path < 0) {
+        path = FindColumn(columns, "Scint path");
+        reflector = FindColumn(columns, "Reflector bounces");
+        guide = FindColumn(columns, "Light guide bounces");
+        tab = FindColumn(columns, "Tab bounces");
+        weight = FindColumn(columns, "Weight");
+
+        if (path < 0 || reflector < 0 || guide < 0 || tab < 0) {
+          std::cerr << "PII_reweight: " << files[f] << " has no path summary,"
+                    << " run with /PII/output/pathSummary true" << std::endl;
+          return 1;
+        }
+      }
+
+      std::vector<double> values;
+      std::stringstream fields(line);
+      std::string field;
+      while (std::getline(fields, field, ',')) values.push_back(std::atof(field.c_str()));
+      if (values.size() < columns.size()) continue;
+
+      if (values[0] != lastPhoton) nPhotons++;
+      lastPhoton = values[0];
+
+      // The second column holds the PMT copy number, or the negative fate
+      // flag of a photon that was not detected
+      int pmt = int(values[1]);
+      if (pmt < 0) continue;
+
+      double scintPath = values[path];
+      int nReflector = int(values[reflector]);
+      int nGuide = int(values[guide]);
+      int nTab = int(values[tab]);
+      double photonWeight = (weight >= 0) ? values[weight] : 1.;
+
+      for (size_t u = 0; u < nVariations; u++) {
+        double w = photonWeight
+                 * std::pow(reflectorRatio[u], nReflector)
+                 * std::pow(guideRatio[u], nGuide)
+                 * std::pow(tabRatio[u], nTab)
+                 * std::exp(-scintPath * inverseAbs[u]);
+
+        Tally& t = tallies[u];
+        t.sumW += w;
+        t.sumW2 += w*w;
+        if (int(t.pmtW.size()) <= pmt) t.pmtW.resize(pmt + 1, 0.);
+        t.pmtW[pmt] += w;
+      }
+    }
+  }
+
+  if (nPhotons == 0) {
+    std::cerr << "PII_reweight: no photons found" << std::endl;
+    return 1;
+  }
+
+  size_t nPMTs = 0;
+  for (size_t u = 0; u < nVariations; u++) {
+    if (tallies[u].pmtW.size() > nPMTs) nPMTs = tallies[u].pmtW.size();
+  }
+
+  std::cout << "variation,reflector,guide,tab,abs_cm,photons,efficiency,error";
+  for (size_t c = 0; c < nPMTs; c++) std::cout << ",pmt" << c;
+  std::cout << "\n";
+
+  for (size_t u = 0; u < nVariations; u++) {
+    const Variation& v = variations[u];
+    Tally& t = tallies[u];
+    t.pmtW.resize(nPMTs, 0.);
+
+    std::cout << v.name << "," << v.reflector << "," << v.guide << "," << v.tab
+              << "," << v.absLength/10. << "," << nPhotons
+              << "," << t.sumW/nPhotons << "," << std::sqrt(t.sumW2)/nPhotons;
+    for (size_t c = 0; c < nPMTs; c++) std::cout << "," << t.pmtW[c];
+    std::cout << "\n";
+  }
+
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
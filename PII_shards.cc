@@ -0,0 +1,368 @@
+/// \file PII_shards.cc
+/// \brief Sharded multi-process run driver and output merge tool for PII
+
+// Usage:
+//   PII_shards <macro> -n events -k shards [-j jobs] [-t threads] [-r runid]
+//              [-o filename] [-b block] [-x PII executable]
+//   PII_shards --merge [-t threads] <output dir> <shard dir> [<shard dir> ...]
+//
+// The first form splits the events into k shards of consecutive global event
+// numbers. Every shard is a separate PII process in shards/shard_<i>, started
+// with the same run id (the run seed) and its own event offset (-e). This
+// gives each shard a disjoint range of per-event seeds. Shard sizes are
+// multiples of -b events, so set -b to bombSize/photonsPerEvent to keep
+// distribution 3 bombs inside one shard. The command line of every shard is
+// written to shards/jobs.txt and at most -j shards run at a time.
+//
+// The shard outputs are then merged into the current directory under the
+// names a single process would use:
+// - CSV ntuples (Geometry, PII_photons_*, PII_bombs_*) are concatenated over
+//   shards and worker threads, keeping one header and one Geometry row.
+// - CSV histograms (output mode 4) are summed bin by bin.
+// - ROOT files are handed to ROOT's hadd. hadd appends trees, so the merged
+//   Geometry tree has one row per shard, all the same; read its first entry.
+// Files are read line by line, so memory does not grow with the output size.
+// Only the _t<N> suffix of worker threads 0 to threads-1 is stripped from
+// file names; --merge without -t strips any _t<N> suffix.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  bool EndsWith(const std::string& s, const std::string& suffix)
+  {
+    return s.size() >= suffix.size()
+        && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  std::vector<std::string> ListFiles(const std::string& dir)
+  {
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return files;
+
+    while (struct dirent* entry = readdir(d)) {
+      struct stat st;
+      std::string path = dir + "/" + entry->d_name;
+      if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+        files.push_back(entry->d_name);
+    }
+    closedir(d);
+
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+  // Worker threads write PII_nt_<name>_t<N>.csv; all of them merge into
+  // PII_nt_<name>.csv. N is the thread number, below the thread count of the
+  // shards, so that a name of the user's own such as run_t5 is kept.
+  std::string MergedName(const std::string& file, int nThreads)
+  {
+    if (file.find("_nt_") == std::string::npos) return file;
+
+    std::string stem = file.substr(0, file.size() - 4);
+    size_t t = stem.rfind("_t");
+    if (t == std::string::npos || t + 2 == stem.size()) return file;
+
+    for (size_t c = t + 2; c < stem.size(); c++) {
+      if (!isdigit(stem[c])) return file;
+    }
+
+    // As the thread number is written, without leading zeros
+    std::string number = stem.substr(t + 2);
+    if (number.size() > 1 && number[0] == '0') return file;
+    if (number.size() > 9 || std::atoi(number.c_str()) >= nThreads) return file;
+
+    return stem.substr(0, t) + ".csv";
+  }
+
+  //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Ntuples: header of the first file, then the rows of every file
+  bool MergeNtuple(const std::string& out, const std::vector<std::string>& inputs,
+                   bool firstRowOnly)
+  {
+    std::ofstream merged(out);
+    if (!merged) return false;
+
+    bool haveRow = false;
+
+    for (size_t f = 0; f < inputs.size(); f++) {
+      std::ifstream in(inputs[f]);
+      std::string line;
+
+      while (std::getline(in, line)) {
+        if (!line.empty() && line[0] == '#') {
+          if (f == 0) merged << line << '\n';
+          continue;
+        }
+        if (line.empty() || (firstRowOnly && haveRow)) continue;
+
+        merged << line << '\n';
+        haveRow = true;
+      }
+    }
+
+    return true;
+  }
+
+  // Histograms: same binning in every shard, sum the numeric lines
+  bool MergeHistogram(const std::string& out, const std::vector<std::string>& inputs)
+  {
+    std::ofstream merged(out);
+    if (!merged) return false;
+
+    std::vector<std::ifstream*> in;
+    for (size_t f = 0; f < inputs.size(); f++) {
+      in.push_back(new std::ifstream(inputs[f]));
+    }
+
+    std::string line;
+    bool ok = true;
+
+    while (std::getline(*in[0], line)) {
+      std::vector<std::string> lines(1, line);
+      for (size_t f = 1; f < in.size(); f++) {
+        std::string other;
+        if (!std::getline(*in[f], other)) ok = false;
+        lines.push_back(other);
+      }
+
+      // Comment and column-name lines are copied from the first shard
+      if (line.empty() || line[0] == '#'
+          || !(isdigit(line[0]) || line[0] == '-' || line[0] == '.')) {
+        merged << line << '\n';
+        continue;
+      }
+
+      std::vector<double> sums;
+      for (size_t f = 0; f < lines.size(); f++) {
+        std::stringstream fields(lines[f]);
+        std::string field;
+        for (size_t c = 0; std::getline(fields, field, ','); c++) {
+          if (c == sums.size()) sums.push_back(0.);
+          sums[c] += std::atof(field.c_str());
+        }
+      }
+
+      char number[32];
+      for (size_t c = 0; c < sums.size(); c++) {
+        std::snprintf(number, sizeof(number), "%.17g", sums[c]);
+        merged << (c ? "," : "") << number;
+      }
+      merged << '\n';
+    }
+
+    for (size_t f = 0; f < in.size(); f++) delete in[f];
+
+    return ok;
+  }
+
+  //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  int Merge(const std::string& outDir, const std::vector<std::string>& shardDirs,
+            int nThreads)
+  {
+    // Output name -> shard files, in shard and thread order
+    std::map<std::string, std::vector<std::string> > groups;
+
+    for (size_t s = 0; s < shardDirs.size(); s++) {
+      std::vector<std::string> files = ListFiles(shardDirs[s]);
+      for (size_t f = 0; f < files.size(); f++) {
+        const std::string& file = files[f];
+        if (!EndsWith(file, ".csv") && !EndsWith(file, ".root")) continue;
+        groups[MergedName(file, nThreads)].push_back(shardDirs[s] + "/" + file);
+      }
+    }
+
+    int failures = 0;
+
+    for (std::map<std::string, std::vector<std::string> >::const_iterator
+           g = groups.begin(); g != groups.end(); ++g) {
+      const std::string& name = g->first;
+      const std::vector<std::string>& inputs = g->second;
+      std::string out = outDir + "/" + name;
+      bool ok;
+
+      if (EndsWith(name, ".root")) {
+        std::string command = "hadd -f \"" + out + "\"";
+        for (size_t f = 0; f < inputs.size(); f++) command += " \"" + inputs[f] + "\"";
+        ok = (std::system(command.c_str()) == 0);
+        if (ok && inputs.size() > 1) {
+          std::cerr << "PII_shards: " << out << ": the Geometry tree has "
+                    << inputs.size() << " identical rows, one per file" << std::endl;
+        }
+      }
+      else if (name.find("_h1_") != std::string::npos
+               || name.find("_h2_") != std::string::npos) {
+        ok = MergeHistogram(out, inputs);
+      }
+      else {
+        ok = MergeNtuple(out, inputs, name.find("_nt_Geometry") != std::string::npos);
+      }
+
+      std::cerr << "PII_shards: " << (ok ? "merged " : "FAILED ") << inputs.size()
+                << " files into " << out << std::endl;
+      if (!ok) failures++;
+    }
+
+    return failures;
+  }
+
+  //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Runs the job list with at most nJobs commands at a time
+  int RunJobs(const std::vector<std::string>& jobs, int nJobs)
+  {
+    std::atomic<size_t> next(0);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> runners;
+
+    for (int j = 0; j < nJobs; j++) {
+      runners.push_back(std::thread([&]() {
+        for (size_t k = next++; k < jobs.size(); k = next++) {
+          if (std::system(jobs[k].c_str()) != 0) {
+            std::cerr << "PII_shards: shard " << k << " failed" << std::endl;
+            failures++;
+          }
+        }
+      }));
+    }
+    for (size_t j = 0; j < runners.size(); j++) runners[j].join();
+
+    return failures;
+  }
+
+  int Usage(const char* name)
+  {
+    std::cerr << "Usage: " << name << " <macro> -n events -k shards [-j jobs]"
+              << " [-t threads] [-r runid] [-o filename] [-b block] [-x PII]\n"
+              << "       " << name << " --merge [-t threads] <output dir> <shard dir>...\n"
+              << "ROOT files are merged with hadd, their Geometry tree keeps one row per shard."
+              << std::endl;
+    return 1;
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) return Usage(argv[0]);
+
+  if (std::string(argv[1]) == "--merge") {
+    // Without the thread count any _t<N> suffix is taken for a thread's
+    int first = 2;
+    int threads = INT_MAX;
+    if (argc > 3 && std::string(argv[2]) == "-t") {
+      threads = std::atoi(argv[3]);
+      first = 4;
+    }
+    if (argc < first + 2 || threads <= 0) return Usage(argv[0]);
+    std::vector<std::string> shardDirs(argv + first + 1, argv + argc);
+    return Merge(argv[first], shardDirs, threads) ? 1 : 0;
+  }
+
+  std::string macro = argv[1];
+  std::string executable = "./PII";
+  std::string runid = "1";
+  std::string output = "";
+  long long nEvents = 0;
+  long long block = 1;
+  int nShards = 1;
+  int nJobs = 0;
+  int nThreads = 1;
+
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i+1 >= argc) return Usage(argv[0]);
+    if (arg == "-n") nEvents = std::atoll(argv[++i]);
+    else if (arg == "-k") nShards = std::atoi(argv[++i]);
+    else if (arg == "-j") nJobs = std::atoi(argv[++i]);
+    else if (arg == "-t") nThreads = std::atoi(argv[++i]);
+    else if (arg == "-r") runid = argv[++i];
+    else if (arg == "-o") output = argv[++i];
+    else if (arg == "-b") block = std::atoll(argv[++i]);
+    else if (arg == "-x") executable = argv[++i];
+    else return Usage(argv[0]);
+  }
+
+  if (nEvents <= 0 || nShards <= 0 || block <= 0) return Usage(argv[0]);
+  if (nJobs <= 0) nJobs = nShards;
+
+  // Shards run in their own directories, so use absolute paths
+  char resolved[PATH_MAX];
+  if (!realpath(executable.c_str(), resolved)) {
+    std::cerr << "PII_shards: cannot find " << executable << std::endl;
+    return 1;
+  }
+  executable = resolved;
+  if (!realpath(macro.c_str(), resolved)) {
+    std::cerr << "PII_shards: cannot find " << macro << std::endl;
+    return 1;
+  }
+  macro = resolved;
+
+  // Whole blocks per shard, the remainder spread over the first shards
+  long long nBlocks = (nEvents + block - 1) / block;
+  std::vector<std::string> jobs;
+  std::vector<std::string> shardDirs;
+  long long offset = 0;
+
+  mkdir("shards", 0755);
+  std::ofstream jobList("shards/jobs.txt");
+
+  for (int s = 0; s < nShards; s++) {
+    long long blocks = nBlocks / nShards + (s < nBlocks % nShards ? 1 : 0);
+    long long events = std::min(blocks * block, nEvents - offset);
+    if (events <= 0) break;
+
+    std::string dir = "shards/shard_" + std::to_string(s);
+    std::system(("rm -rf " + dir).c_str());
+    mkdir(dir.c_str(), 0755);
+
+    std::string command = "cd " + dir + " && \"" + executable + "\" \"" + macro + "\""
+                        + " -n " + std::to_string(events)
+                        + " -t " + std::to_string(nThreads)
+                        + " -r " + runid
+                        + " -e " + std::to_string(offset)
+                        + (output != "" ? " -o " + output : "")
+                        + " > PII.log 2>&1";
+
+    jobList << command << '\n';
+    jobs.push_back(command);
+    shardDirs.push_back(dir);
+    offset += events;
+  }
+  jobList.close();
+
+  std::cerr << "PII_shards: " << nEvents << " events in " << jobs.size()
+            << " shards, " << nJobs << " at a time" << std::endl;
+
+  if (RunJobs(jobs, nJobs) > 0) {
+    std::cerr << "PII_shards: not merging, see shards/shard_*/PII.log" << std::endl;
+    return 1;
+  }
+
+  return Merge(".", shardDirs, nThreads) ? 1 : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -7,16 +7,16 @@
 #include "G4VUserActionInitialization.hh"
 
 class PIIDetectorConstruction;
-class PIIEventAction;
-class PIISteppingAction;
 
 /// Action initialization class.
 ///
+/// Every worker thread builds its own generator, run, event and stepping
+/// actions in Build(); the master only gets a run action to merge results.
 
 class PIIActionInitialization : public G4VUserActionInitialization
 {
   public:
-    PIIActionInitialization(PIIDetectorConstruction*, PIIEventAction*, PIISteppingAction*);
+    PIIActionInitialization(PIIDetectorConstruction*);
     virtual ~PIIActionInitialization();
 
     virtual void BuildForMaster() const;
@@ -24,8 +24,6 @@ class PIIActionInitialization : public G4VUserActionInitialization
 
   private:
     PIIDetectorConstruction* fDetConstruction;
-    PIIEventAction* fEventAction;
-    PIISteppingAction* fStepAction;
 };
 
 #endif
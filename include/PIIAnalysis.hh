@@ -4,8 +4,30 @@
 #ifndef PIIAnalysis_h
 #define PIIAnalysis_h 1
 
-//#include "g4root.hh"
-#include "g4csv.hh"
-//#include "g4xml.hh"
+#include "G4VAnalysisManager.hh"
+#include "globals.hh"
+
+/// Selection of the analysis technology
+///
+/// The output backend is chosen at run time with /PII/output/format:
+/// "csv" writes one text file per ntuple, "root" writes a single compressed
+/// ROOT file, with the worker ntuples merged in multithreaded runs, and
+/// "xml" is kept for debugging. All backends book the same ntuples, so the
+/// actions only talk to the G4VAnalysisManager interface.
+
+class PIIAnalysis
+{
+  public:
+    static G4VAnalysisManager* Instance();
+    static G4bool              SetFormat(const G4String& format);
+    static G4String            GetFormat();
+    static void                DeleteInstance();
+
+  private:
+    static G4ThreadLocal G4VAnalysisManager* fManager;
+    static G4ThreadLocal G4int               fFormat;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #endif
@@ -0,0 +1,55 @@
+/// \file PIIBiasingMessenger.hh
+/// \brief Definition of the PIIBiasingMessenger class
+
+#ifndef PIIBiasingMessenger_h
+#define PIIBiasingMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PIIRunAction;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Messenger class that defines the optical biasing commands of PIIRunAction.
+///
+/// It implements commands:
+/// - /PII/bias/rouletteBounces n
+/// - /PII/bias/rouletteLength value unit
+/// - /PII/bias/survival p
+/// - /PII/bias/splitting n
+/// - /PII/bias/direction mode
+/// - /PII/bias/coneAngle value unit
+/// - /PII/bias/coneFraction f
+/// - /PII/bias/directionMap file
+
+class PIIBiasingMessenger: public G4UImessenger
+{
+  public:
+    PIIBiasingMessenger(PIIRunAction*);
+    virtual ~PIIBiasingMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    PIIRunAction*              fRunAction;
+
+    G4UIdirectory*             fBiasDirectory;
+    G4UIcmdWithAnInteger*      fRouletteBouncesCmd;
+    G4UIcmdWithADoubleAndUnit* fRouletteLengthCmd;
+    G4UIcmdWithADouble*        fSurvivalCmd;
+    G4UIcmdWithAnInteger*      fSplittingCmd;
+    G4UIcmdWithAString*        fDirectionCmd;
+    G4UIcmdWithADoubleAndUnit* fConeAngleCmd;
+    G4UIcmdWithADouble*        fConeFractionCmd;
+    G4UIcmdWithAString*        fDirectionMapCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
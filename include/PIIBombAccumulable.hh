@@ -0,0 +1,74 @@
+/// \file PIIBombAccumulable.hh
+/// \brief Definition of the PIIBombAccumulable class
+
+#ifndef PIIBombAccumulable_h
+#define PIIBombAccumulable_h 1
+
+#include "G4VAccumulable.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Hits of one bomb in the two PMTs of the segment that holds it.
+
+struct PIIBomb
+{
+  G4ThreeVector pos;     // bomb position
+  G4double      left;    // hits in the PMT on the -z side
+  G4double      right;   // hits in the PMT on the +z side
+  G4long        photons; // photons of the bomb seen so far
+
+  PIIBomb() : left(0.), right(0.), photons(0) {}
+};
+
+/// Bomb tallies by bomb number.
+///
+/// The photons of one bomb may be spread over several events, and so over
+/// several threads. Each thread adds its photons to the bombs they belong
+/// to, the G4AccumulableManager adds the worker tallies into the master
+/// instance at the end of the run, and the master writes the bombs that got
+/// all their photons. The bombs of the run are known when it starts, so
+/// they are kept in a vector sized then, indexed from the first bomb, and
+/// the event loop does not allocate.
+
+class PIIBombAccumulable : public G4VAccumulable
+{
+  public:
+    PIIBombAccumulable(const G4String& name);
+    virtual ~PIIBombAccumulable();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    void   SetBombs(G4long firstBomb, G4long nbOfBombs, G4int bombSize);
+    G4int  GetBombSize() const;
+    G4long GetFirstBomb() const;
+    void   AddPhoton(G4long bombNo, const G4ThreeVector& pos,
+                     G4double left, G4double right);
+
+    const std::vector<PIIBomb>& GetBombs() const;
+
+  private:
+    G4int  fBombSize;
+    G4long fFirstBomb;             // number of fBombs[0]
+    std::vector<PIIBomb> fBombs;
+};
+
+// inline functions
+
+inline G4int PIIBombAccumulable::GetBombSize() const {
+  return fBombSize;
+}
+
+inline G4long PIIBombAccumulable::GetFirstBomb() const {
+  return fFirstBomb;
+}
+
+inline const std::vector<PIIBomb>& PIIBombAccumulable::GetBombs() const {
+  return fBombs;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
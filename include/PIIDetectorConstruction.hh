@@ -7,15 +7,37 @@
 #include "globals.hh"
 #include "G4VUserDetectorConstruction.hh"
 #include "G4OpticalSurface.hh"
+#include "G4LogicalVolume.hh"
+#include "G4RotationMatrix.hh"
+#include "G4ThreeVector.hh"
 #include "tls.hh"
 
+#include <vector>
+
 class G4VPhysicalVolume;
-class G4LogicalVolume;
+class G4VSolid;
 class G4Material;
 class G4UserLimits;
 class G4GlobalMagFieldMessenger;
 
 class PIIDetectorMessenger;
+class PIIScintFastModel;
+
+/// Role a logical volume plays in the optical readout, looked up per step
+/// by the stepping action and the sensitive detector instead of comparing
+/// volume names.
+
+enum PIIVolumeRole {
+  kOtherVolume = 0,
+  kCathodeVolume,
+  kHousingVolume,
+  kReflectorVolume,
+  kScintillatorVolume,
+  kLightGuideVolume,
+  kTabVolume,
+  kTankVolume,
+  kNbOfVolumeRoles
+};
 
 /// Detector construction class to define materials, geometry
 /// and global uniform magnetic field.
@@ -32,22 +54,44 @@ class PIIDetectorConstruction : public G4VUserDetectorConstruction
     virtual G4int GetNoPMT();
     virtual G4int GetNoRows();
     virtual G4int GetNoCols();
+    PIIVolumeRole GetVolumeRole(const G4LogicalVolume* volume) const;
+    const G4Material* GetScintMaterial() const;
+    const G4Material* GetOilMaterial() const;
+    G4double GetMountPlaneZ() const;
+    G4int GetSegment(const G4ThreeVector& position) const;
+    G4ThreeVector GetSegmentCentre(G4int segment) const;
 
     // Set methods
     void SetMaxStep(G4double);
     void SetCheckOverlaps(G4bool);
+    void SetReplicate(G4bool);
+    void SetPrimitiveSolids(G4bool);
+    void SetFastSimulation(G4bool);
     void SetRowNumb(G4int);
     void SetColNumb(G4int);
     void SetWindowThickness(G4double);
     void SetHousingThickness(G4double);
     void SetDefaults();
 
+    // Compares the boolean and primitive bulb and light guide solids
+    void TestSolids(G4int nbOfRays);
+
   private:
     // methods
     void DefineMaterials();
     G4VPhysicalVolume* DefineVolumes();
+    void SetVolumeRole(const G4LogicalVolume* volume, PIIVolumeRole role);
+    G4VSolid* BuildBulbSolid(G4bool primitive);
+    G4VSolid* BuildGuideSolid(G4bool primitive);
+    G4VSolid* BuildTessellatedGuide(G4double halfWidth, G4double holeHalfWidth,
+                                    G4double rBottom, G4double rTop,
+                                    G4double halfLength);
+    void CompareSolids(const G4String& name, const G4VSolid* boolean,
+                       const G4VSolid* primitive, const G4RotationMatrix& frame,
+                       G4int nbOfRays) const;
 
     // data members
+    G4bool fMaterialsDefined;           // materials and surfaces are built once
     G4int fRowNum;
     G4int fColNum;
     G4double fWindowThickness;
@@ -70,6 +114,22 @@ class PIIDetectorConstruction : public G4VUserDetectorConstruction
     G4OpticalSurface* tabMatSurf;
 
     G4LogicalVolume**   fLogicReflector; // pointer to the logical Reflector array
+    G4VPhysicalVolume*  fWorldPV;        // current world, replaced on rebuilds
+    G4double            fMountPlaneZ;    // |z| of the PMT mounts, at the
+                                         // outer face of the end windows
+    G4double            fSegmentWidth;   // pitch of the segment array
+
+    G4VSolid*           fBulbSolid[2];   // boolean and primitive PMT bulb
+    G4VSolid*           fGuideSolid[2];  // boolean and tessellated light guide,
+                                         // the unselected ones only after
+                                         // /PII/det/testSolids
+    G4double            fBulbInner;      // bulb and light guide sizes of the
+    G4double            fBulbRadius;     // last build, to build the other
+    G4double            fBulbCut;        // version of the solids for
+    G4double            fGuideWidth;     // TestSolids()
+
+    std::vector<G4int>  fVolumeRoles;    // PIIVolumeRole by logical volume
+                                         // instance ID, filled in DefineVolumes
 
     G4UserLimits* fStepLimit;            // pointer to user step limits
 
@@ -77,8 +137,14 @@ class PIIDetectorConstruction : public G4VUserDetectorConstruction
 
     static G4ThreadLocal G4GlobalMagFieldMessenger*  fMagFieldMessenger;
                                          // magnetic field messenger
+    static G4ThreadLocal PIIScintFastModel*  fScintModel;
+                                         // fast model of this thread
 
     G4bool  fCheckOverlaps; // option to activate checking of volumes overlaps
+    G4bool  fReplicate;     // option to build the segment and PMT arrays
+                            // from replicated cells
+    G4bool  fPrimitiveSolids; // option to build the tank, housings, bulbs and
+                              // light guides without boolean solids
 };
 
 // inline functions
@@ -95,6 +161,25 @@ inline G4int PIIDetectorConstruction::GetNoCols() {
   return fColNum;
 }
 
+inline PIIVolumeRole PIIDetectorConstruction::GetVolumeRole(
+                       const G4LogicalVolume* volume) const {
+  size_t id = volume->GetInstanceID();
+  return id < fVolumeRoles.size() ? PIIVolumeRole(fVolumeRoles[id])
+                                  : kOtherVolume;
+}
+
+inline const G4Material* PIIDetectorConstruction::GetScintMaterial() const {
+  return scintMat;
+}
+
+inline const G4Material* PIIDetectorConstruction::GetOilMaterial() const {
+  return minOil;
+}
+
+inline G4double PIIDetectorConstruction::GetMountPlaneZ() const {
+  return fMountPlaneZ;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #endif
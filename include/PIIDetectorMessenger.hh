@@ -12,6 +12,7 @@ class G4UIdirectory;
 class G4UIcmdWithAString;
 class G4UIcmdWithADoubleAndUnit;
 class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -21,6 +22,11 @@ class G4UIcmdWithAnInteger;
 /// - /PII/det/setTargetMaterial name
 /// - /PII/det/setChamberMaterial name
 /// - /PII/det/stepMax value unit
+/// - /PII/det/replicate bool
+/// - /PII/det/checkOverlaps bool
+/// - /PII/det/primitiveSolids bool
+/// - /PII/det/testSolids nbOfRays
+/// - /PII/fastsim/scintillator bool
 
 class PIIDetectorMessenger: public G4UImessenger
 {
@@ -35,6 +41,7 @@ class PIIDetectorMessenger: public G4UImessenger
 
     G4UIdirectory*           fPIIDirectory;
     G4UIdirectory*           fDetDirectory;
+    G4UIdirectory*           fFastSimDirectory;
 
     G4UIcmdWithADoubleAndUnit* fStepMaxCmd;
     G4UIcmdWithADoubleAndUnit* fHousingThicknessCmd;
@@ -42,6 +49,11 @@ class PIIDetectorMessenger: public G4UImessenger
     G4UIcmdWithAnInteger*      fRowNumberCmd;
     G4UIcmdWithAnInteger*      fColNumberCmd;
     G4UIcommand*               fDefaultsCmd;
+    G4UIcmdWithABool*          fReplicateCmd;
+    G4UIcmdWithABool*          fCheckOverlapsCmd;
+    G4UIcmdWithABool*          fPrimitiveSolidsCmd;
+    G4UIcmdWithAnInteger*      fTestSolidsCmd;
+    G4UIcmdWithABool*          fFastSimCmd;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,94 @@
+/// \file PIIDirectionBias.hh
+/// \brief Definition of the PIIDirectionBias class
+
+#ifndef PIIDirectionBias_h
+#define PIIDirectionBias_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Biased sampling of the direction of isotropic primary photons.
+///
+/// Sample() draws a direction and returns its importance weight, the ratio
+/// of the isotropic density 1/4pi to the density it was drawn from, so that
+/// weighted tallies keep the expectation of the unbiased source.
+///
+/// - kCones: with probability fConeFraction the photon goes into one of two
+///   cones of half-angle fConeAngle around +z and -z, towards the end faces
+///   and the light guides of its segment, otherwise it is isotropic. Beyond
+///   90 degrees the cones overlap and the density adds both.
+/// - kMap: cos(theta) to the z axis is drawn from bins of equal solid angle
+///   with probabilities proportional to the importances read by ReadMap().
+///
+/// Every direction keeps a non-zero density, so no part of the unbiased
+/// source is left out.
+
+class PIIDirectionBias
+{
+  public:
+    enum Mode {
+      kNone = 0,  // isotropic, weight 1
+      kCones,     // cones towards both ends
+      kMap        // importance map in cos(theta)
+    };
+
+    PIIDirectionBias();
+    ~PIIDirectionBias();
+
+    G4double Sample(G4ThreeVector& dir) const;
+
+    G4bool   ReadMap(const G4String& fileName);
+
+    void     SetMode(G4int mode);
+    G4int    GetMode() const;
+    void     SetConeAngle(G4double angle);
+    G4double GetConeAngle() const;
+    void     SetConeFraction(G4double fraction);
+    G4double GetConeFraction() const;
+    G4bool   IsEmpty() const;
+
+  private:
+    G4int    fMode;
+    G4double fConeAngle;
+    G4double fConeFraction;
+
+    std::vector<G4double> fImportance; // per cos(theta) bin, from -1 to 1
+    std::vector<G4double> fCumulative; // normalized running sum
+    G4double              fMeanImportance;
+};
+
+// inline functions
+
+inline void PIIDirectionBias::SetMode(G4int mode) {
+  fMode = mode;
+}
+
+inline G4int PIIDirectionBias::GetMode() const {
+  return fMode;
+}
+
+inline void PIIDirectionBias::SetConeAngle(G4double angle) {
+  fConeAngle = angle;
+}
+
+inline G4double PIIDirectionBias::GetConeAngle() const {
+  return fConeAngle;
+}
+
+inline void PIIDirectionBias::SetConeFraction(G4double fraction) {
+  fConeFraction = fraction;
+}
+
+inline G4double PIIDirectionBias::GetConeFraction() const {
+  return fConeFraction;
+}
+
+inline G4bool PIIDirectionBias::IsEmpty() const {
+  return fImportance.empty();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
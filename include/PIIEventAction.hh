@@ -9,11 +9,40 @@
 #include "G4SystemOfUnits.hh"
 #include "G4ThreeVector.hh"
 
+#include "PIIOutputWriter.hh"
+#include "PIIEventRecord.hh"
+
 #include "globals.hh"
 
+#include <vector>
+
 class PIIDetectorConstruction;
+class G4VAnalysisManager;
+class PIILightMap;
+class PIIUniverseAccumulable;
+class PIIBombAccumulable;
+class G4Track;
+class PIIDirectionBias;
 
 /// Event action class
+///
+/// An event carries one or more primary photons. The stepping action records
+/// photons lost in the housing or elsewhere by track ID, cathode hits come
+/// from the PMT hits collection, and EndOfEventAction() writes one output
+/// row per photon and tallies the hits of each bomb. With SetPathSummary() the
+/// photon rows also carry the scintillator path length and the reflections
+/// off each reflective skin, for reweighting with PII_reweight. With
+/// SetUniverses() every detected photon is also tallied, with its weight, in
+/// each universe of alternate optical parameters.
+/// With biasing (/PII/bias/) photons carry weights: split copies of a photon
+/// get rows of their own, with the number of the photon they were split
+/// from, and every tally adds weights instead of counting photons. SetBiased()
+/// adds the weight to the photon and bomb rows. Primary photons start with
+/// the importance weight the generator gave them, drawn from the direction
+/// biasing of SetDirectionBias().
+/// All per-event data lives in a PIIEventRecord sized by SetNoPMT() and
+/// ReserveCopies() at the start of the run, so events are processed without
+/// heap allocation.
 
 class PIIEventAction : public G4UserEventAction
 {
@@ -23,63 +52,83 @@ class PIIEventAction : public G4UserEventAction
 
     virtual void           BeginOfEventAction(const G4Event*);
     virtual void           EndOfEventAction(const G4Event*);
-    virtual void           AddPhotonHit(G4int PMTno);
-    virtual G4int          GetPhotonHit(G4int PMTno);
-    virtual G4int          GetPhotonHit2(G4int PMTno);
-    virtual void           ResetPhotonHits(G4int PMTno);
+    virtual void           SetNoPMT(G4int nbOfPMTs);
+    virtual void           ReserveCopies(G4int photonsPerEvent, G4int splitting);
     virtual void           SetNoEvents(G4int nEvents);
     virtual G4int          GetNoEvents();
-    virtual void           SetEventTime(G4double time);
-    virtual G4double       GetEventTime();
-    virtual void           SetPos(G4ThreeVector pos);
-    virtual G4ThreeVector  GetPos();
-    virtual void           SetDirection(G4ThreeVector dir);
-    virtual G4ThreeVector  GetDirection();
     virtual void           SetNoRows(G4int rowNum);
     virtual G4int          GetNoRows();
     virtual void           SetNoCols(G4int colNum);
     virtual G4int          GetNoCols();
-    virtual void           SetCurrentPMTHit(G4int pmtHit);
-    virtual G4int          GetCurrentPMTHit();
-    virtual void           SetPhotonFlag(G4int flag);
-    virtual G4int          GetPhotonFlag();
+    void                   SetPhotonHit(G4int trackID, G4int PMTno, G4double time);
+    void                   SetPhotonFlag(G4int trackID, G4int flag);
+    void                   SetPhotonWeight(G4int trackID, G4double weight);
+    void                   AddPhotonCopy(G4int trackID, const G4Track* copy);
+    void                   AssignPhotonCopy(const G4Track* copy, G4int trackID);
+    G4bool                 IsPrimaryPhoton(G4int trackID) const;
+    void                   AddScintPath(G4int trackID, G4double length);
+    void                   AddBounce(G4int trackID, G4int role);
+    void                   AddDepth(G4int trackID, G4bool scint, G4double depth);
+    const PIIEventRecord&  GetEventRecord() const;
+    virtual void           SetPhotonsPerEvent(G4int nPhotons);
+    virtual G4int          GetPhotonsPerEvent();
+    virtual void           SetBombSize(G4int bombSize);
+    virtual G4int          GetBombSize();
+    virtual void           SetEventOffset(G4long offset);
+    virtual void           SetOutputWriter(PIIOutputWriter* writer);
+    virtual void           SetLightMap(PIILightMap* map);
+    virtual void           SetUniverses(PIIUniverseAccumulable* universes);
+    G4bool                 HasUniverses() const;
+    virtual void           SetBombs(PIIBombAccumulable* bombs);
     virtual void           SetOutputFiles(G4int outputs);
     virtual G4int          GetOutputFiles();
+    virtual void           SetPhotonNtuple(G4int id);
+    virtual void           SetHistograms(G4int sources, G4int hits, G4int timeSum, G4int times);
+    virtual void           SetPathSummary(G4bool summary);
+    virtual G4bool         GetPathSummary();
+    virtual void           SetBiased(G4bool biased);
+    virtual G4bool         GetBiased();
+    virtual void           SetDirectionBias(const PIIDirectionBias* bias);
+    const PIIDirectionBias* GetDirectionBias() const;
 
     G4int eventID;
-    G4int* PMTHits;
-    G4int* PMTHits2;
     G4int nEvent;
-    G4double nTime;
-    G4ThreeVector nPos;
-    G4ThreeVector nDir;
     G4int fRowNum;
     G4int fColNum;
-    G4int currentPMT;
-    G4int photonFlag;
     G4int outputFlag;
+    G4int fPhotonsPerEvent;
+    G4int fBombSize;
+    G4long fEventOffset;
+    G4bool fPathSummary;
+    G4int fPhotonNtuple;
+    G4int fSourcesH1;
+    G4int fHitsH2;
+    G4int fTimeSumH2;
+    G4int fTimesH2;
+    G4bool fBiased;
 
   private:
+    void FillRow(G4VAnalysisManager* man, const PIIOutputRecord& row);
+    void CollectPMTHits(const G4Event* event);
+
+    PIIOutputWriter* fOutputWriter;
+    PIILightMap* fLightMap;
+    PIIUniverseAccumulable* fUniverses;
+    PIIBombAccumulable* fBombs;
+    const PIIDirectionBias* fDirectionBias;
     PIIDetectorConstruction* fDetConstruction;
+    G4int fPMTHitsCollectionID;
+    PIIEventRecord fRecord;
 };
 
 // inline functions
 
-inline void PIIEventAction::AddPhotonHit(G4int PMTno) {
-  PMTHits[PMTno] = PMTHits[PMTno] + 1;
-  PMTHits2[PMTno] = PMTHits2[PMTno] + 1;
-}
-
-inline G4int PIIEventAction::GetPhotonHit(G4int PMTno) {
-  return PMTHits[PMTno];
+inline void PIIEventAction::SetNoPMT(G4int nbOfPMTs) {
+  fRecord.Allocate(nbOfPMTs, fPhotonsPerEvent);
 }
 
-inline G4int PIIEventAction::GetPhotonHit2(G4int PMTno) {
-  return PMTHits2[PMTno];
-}
-
-inline void PIIEventAction::ResetPhotonHits(G4int PMTno) {
-  PMTHits[PMTno] = 0;
+inline void PIIEventAction::ReserveCopies(G4int photonsPerEvent, G4int splitting) {
+  fRecord.Reserve(photonsPerEvent, splitting);
 }
 
 inline void PIIEventAction::SetNoEvents(G4int nEvents) {
@@ -90,60 +139,100 @@ inline G4int PIIEventAction::GetNoEvents() {
   return nEvent;
 }
 
-inline void PIIEventAction::SetEventTime(G4double time) {
-  nTime = time;
+inline void PIIEventAction::SetNoRows(G4int rowNum) {
+  fRowNum = rowNum;
 }
 
-inline G4double PIIEventAction::GetEventTime() {
-  return nTime;
+inline G4int PIIEventAction::GetNoRows() {
+  return fRowNum;
 }
 
-inline void PIIEventAction::SetPos(G4ThreeVector pos) {
-  nPos = pos;
+inline void PIIEventAction::SetNoCols(G4int colNum) {
+  fColNum = colNum;
 }
 
-inline G4ThreeVector PIIEventAction::GetPos() {
-  return nPos;
+inline G4int PIIEventAction::GetNoCols() {
+  return fColNum;
 }
 
-inline void PIIEventAction::SetDirection(G4ThreeVector dir) {
-  nDir = dir;
+inline void PIIEventAction::SetPhotonHit(G4int trackID, G4int PMTno, G4double time) {
+  fRecord.SetHit(trackID, PMTno, time);
 }
 
-inline G4ThreeVector PIIEventAction::GetDirection() {
-  return nDir;
+inline void PIIEventAction::SetPhotonFlag(G4int trackID, G4int flag) {
+  fRecord.SetFlag(trackID, flag);
 }
 
-inline void PIIEventAction::SetNoRows(G4int rowNum) {
-  fRowNum = rowNum;
+inline void PIIEventAction::SetPhotonWeight(G4int trackID, G4double weight) {
+  fRecord.SetWeight(trackID, weight);
 }
 
-inline G4int PIIEventAction::GetNoRows() {
-  return fRowNum;
+inline void PIIEventAction::AddPhotonCopy(G4int trackID, const G4Track* copy) {
+  fRecord.AddCopy(trackID, copy);
 }
 
-inline void PIIEventAction::SetNoCols(G4int colNum) {
-  fColNum = colNum;
+inline void PIIEventAction::AssignPhotonCopy(const G4Track* copy, G4int trackID) {
+  fRecord.AssignCopy(copy, trackID);
 }
 
-inline G4int PIIEventAction::GetNoCols() {
-  return fColNum;
+inline G4bool PIIEventAction::IsPrimaryPhoton(G4int trackID) const {
+  return trackID >= 1 && trackID <= fRecord.nPhotons;
+}
+
+inline void PIIEventAction::AddScintPath(G4int trackID, G4double length) {
+  fRecord.AddScintPath(trackID, length);
+}
+
+inline void PIIEventAction::AddBounce(G4int trackID, G4int role) {
+  fRecord.AddBounce(trackID, role);
+}
+
+inline void PIIEventAction::AddDepth(G4int trackID, G4bool scint, G4double depth) {
+  fRecord.AddDepth(trackID, scint, depth);
+}
+
+inline const PIIEventRecord& PIIEventAction::GetEventRecord() const {
+  return fRecord;
+}
+
+inline void PIIEventAction::SetPhotonsPerEvent(G4int nPhotons) {
+  fPhotonsPerEvent = nPhotons;
+}
+
+inline G4int PIIEventAction::GetPhotonsPerEvent() {
+  return fPhotonsPerEvent;
+}
+
+inline void PIIEventAction::SetBombSize(G4int bombSize) {
+  fBombSize = bombSize;
 }
 
-inline void PIIEventAction::SetCurrentPMTHit(G4int copyNo) {
-  currentPMT = copyNo;
+inline G4int PIIEventAction::GetBombSize() {
+  return fBombSize;
 }
 
-inline G4int PIIEventAction::GetCurrentPMTHit() {
-  return currentPMT;
+inline void PIIEventAction::SetEventOffset(G4long offset) {
+  fEventOffset = offset;
 }
 
-inline void PIIEventAction::SetPhotonFlag(G4int flag) {
-  photonFlag = flag;
+inline void PIIEventAction::SetOutputWriter(PIIOutputWriter* writer) {
+  fOutputWriter = writer;
 }
 
-inline G4int PIIEventAction::GetPhotonFlag() {
-  return photonFlag;
+inline void PIIEventAction::SetLightMap(PIILightMap* map) {
+  fLightMap = map;
+}
+
+inline void PIIEventAction::SetUniverses(PIIUniverseAccumulable* universes) {
+  fUniverses = universes;
+}
+
+inline G4bool PIIEventAction::HasUniverses() const {
+  return fUniverses != nullptr;
+}
+
+inline void PIIEventAction::SetBombs(PIIBombAccumulable* bombs) {
+  fBombs = bombs;
 }
 
 inline void PIIEventAction::SetOutputFiles(G4int outputs) {
@@ -154,6 +243,44 @@ inline G4int PIIEventAction::GetOutputFiles() {
   return outputFlag;
 }
 
+inline void PIIEventAction::SetPhotonNtuple(G4int id) {
+  fPhotonNtuple = id;
+}
+
+// H1 of the sources, H2s of the hits and summed times per PMT and first
+// of the two per-plane time H2s
+inline void PIIEventAction::SetHistograms(G4int sources, G4int hits, G4int timeSum,
+                                          G4int times) {
+  fSourcesH1 = sources;
+  fHitsH2 = hits;
+  fTimeSumH2 = timeSum;
+  fTimesH2 = times;
+}
+
+inline void PIIEventAction::SetPathSummary(G4bool summary) {
+  fPathSummary = summary;
+}
+
+inline G4bool PIIEventAction::GetPathSummary() {
+  return fPathSummary;
+}
+
+inline void PIIEventAction::SetBiased(G4bool biased) {
+  fBiased = biased;
+}
+
+inline G4bool PIIEventAction::GetBiased() {
+  return fBiased;
+}
+
+inline void PIIEventAction::SetDirectionBias(const PIIDirectionBias* bias) {
+  fDirectionBias = bias;
+}
+
+inline const PIIDirectionBias* PIIEventAction::GetDirectionBias() const {
+  return fDirectionBias;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #endif
@@ -0,0 +1,252 @@
+/// \file PIIEventRecord.hh
+/// \brief Definition of the PIIEventRecord struct
+
+#ifndef PIIEventRecord_h
+#define PIIEventRecord_h 1
+
+#include "G4ThreeVector.hh"
+#include "PIIDetectorConstruction.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+class G4Track;
+
+/// Per-thread event record: the primary photons of the current event and the
+/// per-PMT counters of the thread, as a struct of arrays.
+///
+/// The path summary of each photon, its path length in the scintillator and
+/// its reflections off reflector, light guide and tab skins, lets a run be
+/// reweighted afterwards to other reflectivities and attenuation lengths.
+/// With universes (/PII/universe/add) the optical depths in the scintillator
+/// and the oil are kept as well.
+///
+/// Photons split by /PII/bias/splitting get rows of their own after the
+/// primaries, with the source and path summary of the photon they were split
+/// from. AddCopy() makes the row when the copy is created, AssignCopy() maps
+/// its track ID to it once the copy is stacked. The per-PMT counters are
+/// sums of photon weights, which are 1 without biasing.
+///
+/// Allocate() sizes the arrays at the start of each run and Reserve() makes
+/// room for the photons of an event and their copies under the splitting
+/// factor of the run. Reset() at the start of each event only rewinds the
+/// photon count, so events do not touch the heap unless one carries more
+/// photons or copies than expected.
+
+struct PIIEventRecord
+{
+  // One entry per photon row: the primaries, index = track ID - 1, then the
+  // split copies in the order they were made
+  std::vector<G4ThreeVector> pos;
+  std::vector<G4ThreeVector> dir;
+  std::vector<G4int>         flag; // 1 PMT hit, -1 killed in housing, -2 lost elsewhere
+  std::vector<G4int>         pmt;  // PMT copy number when hit
+  std::vector<G4double>      time; // hit time
+  std::vector<G4double>      weight;            // weight when the track ended
+  std::vector<G4double>      scintPath;         // path length in ScintMat
+  std::vector<G4int>         reflectorBounces;  // reflections off surfOpt
+  std::vector<G4int>         guideBounces;      // reflections off surfLightG
+  std::vector<G4int>         tabBounces;        // reflections off tabMatSurf
+  std::vector<G4double>      scintDepth;        // path over ABSLENGTH in ScintMat
+  std::vector<G4double>      oilDepth;          // path over ABSLENGTH in oil
+  std::vector<G4int>         nextCopy;          // next row of the same primary, or -1
+  std::vector<G4int>         lastCopy;          // last row of each primary
+  G4int                      nPhotons;          // primary photons
+  G4int                      nRows;             // primaries and copies
+
+  // Rows of the copies by track ID - nPhotons - 1, and the copies made in
+  // the current step that have no track ID yet
+  std::vector<G4int>         copyRows;
+  std::vector<std::pair<const G4Track*, G4int> > pendingCopies;
+
+  // One entry per PMT
+  std::vector<G4double>      runHits;     // hits of this thread in the run
+  std::vector<G4double>      runTimeSum;  // sum of hit times in the run
+  std::vector<G4double>      runTimeSum2; // sum of squared hit times
+
+  // Photon fates of this thread in the run
+  G4double                   runDetected;
+  G4double                   runHousing;
+  G4double                   runLost;
+
+  PIIEventRecord()
+   : nPhotons(0), nRows(0), runDetected(0.), runHousing(0.), runLost(0.) {}
+
+  void  Allocate(G4int nbOfPMTs, G4int photonsPerEvent);
+  void  Reset(G4int photons);
+  void  Resize(G4int rows);
+  void  Reserve(G4int photons, G4int splitting);
+  G4int Row(G4int trackID) const;
+  G4int AddCopy(G4int trackID, const G4Track* copy);
+  void  AssignCopy(const G4Track* copy, G4int trackID);
+  void  SetHit(G4int trackID, G4int PMTno, G4double hitTime);
+  void  SetFlag(G4int trackID, G4int fate);
+  void  SetWeight(G4int trackID, G4double trackWeight);
+  void  AddScintPath(G4int trackID, G4double length);
+  void  AddBounce(G4int trackID, G4int role);
+  void  AddDepth(G4int trackID, G4bool scint, G4double depth);
+};
+
+// inline functions
+
+inline void PIIEventRecord::Allocate(G4int nbOfPMTs, G4int photonsPerEvent) {
+  runHits.assign(nbOfPMTs, 0.);
+  runTimeSum.assign(nbOfPMTs, 0.);
+  runTimeSum2.assign(nbOfPMTs, 0.);
+  runDetected = 0.;
+  runHousing = 0.;
+  runLost = 0.;
+  Resize(photonsPerEvent);
+  nPhotons = 0;
+  nRows = 0;
+}
+
+inline void PIIEventRecord::Resize(G4int rows) {
+  pos.resize(rows);
+  dir.resize(rows);
+  flag.resize(rows);
+  pmt.resize(rows);
+  time.resize(rows);
+  weight.resize(rows);
+  scintPath.resize(rows);
+  reflectorBounces.resize(rows);
+  guideBounces.resize(rows);
+  tabBounces.resize(rows);
+  scintDepth.resize(rows);
+  oilDepth.resize(rows);
+  nextCopy.resize(rows);
+  lastCopy.resize(rows);
+}
+
+// Each split makes splitting - 1 copies in one step; copies may be split
+// again, so this is the room for one split per primary
+inline void PIIEventRecord::Reserve(G4int photons, G4int splitting) {
+  G4int copies = photons * (std::max(splitting, 1) - 1);
+  if (photons + copies > (G4int)flag.size()) Resize(photons + copies);
+  copyRows.reserve(copies);
+  pendingCopies.reserve(std::max(splitting, 1) - 1);
+}
+
+inline void PIIEventRecord::Reset(G4int photons) {
+  if (photons > (G4int)flag.size()) Resize(photons);
+  nPhotons = photons;
+  nRows = photons;
+  copyRows.clear();
+  pendingCopies.clear();
+
+  std::fill(flag.begin(), flag.begin() + photons, -2);
+  std::fill(pmt.begin(), pmt.begin() + photons, 0);
+  std::fill(time.begin(), time.begin() + photons, 0.);
+  std::fill(weight.begin(), weight.begin() + photons, 1.);
+  std::fill(scintPath.begin(), scintPath.begin() + photons, 0.);
+  std::fill(reflectorBounces.begin(), reflectorBounces.begin() + photons, 0);
+  std::fill(guideBounces.begin(), guideBounces.begin() + photons, 0);
+  std::fill(tabBounces.begin(), tabBounces.begin() + photons, 0);
+  std::fill(scintDepth.begin(), scintDepth.begin() + photons, 0.);
+  std::fill(oilDepth.begin(), oilDepth.begin() + photons, 0.);
+  std::fill(nextCopy.begin(), nextCopy.begin() + photons, -1);
+  for (G4int k = 0; k < photons; k++) lastCopy[k] = k;
+}
+
+// Primary photons are tracks 1..n in vertex order, copies are looked up,
+// anything else is ignored
+inline G4int PIIEventRecord::Row(G4int trackID) const {
+  if (trackID < 1) return -1;
+  if (trackID <= nPhotons) return trackID - 1;
+  size_t c = trackID - nPhotons - 1;
+  return (c < copyRows.size()) ? copyRows[c] : -1;
+}
+
+// New row for a copy of the photon of the given track, which carries over
+// its source and path summary
+inline G4int PIIEventRecord::AddCopy(G4int trackID, const G4Track* copy) {
+  G4int parent = Row(trackID);
+  if (parent < 0) return -1;
+  if (nRows >= (G4int)flag.size()) Resize(2*nRows);
+
+  G4int row = nRows++;
+  pos[row] = pos[parent];
+  dir[row] = dir[parent];
+  flag[row] = -2;
+  pmt[row] = 0;
+  time[row] = 0.;
+  weight[row] = 1.;
+  scintPath[row] = scintPath[parent];
+  reflectorBounces[row] = reflectorBounces[parent];
+  guideBounces[row] = guideBounces[parent];
+  tabBounces[row] = tabBounces[parent];
+  scintDepth[row] = scintDepth[parent];
+  oilDepth[row] = oilDepth[parent];
+
+  // Append to the rows of the primary
+  G4int primary = (parent < nPhotons) ? parent : lastCopy[parent];
+  nextCopy[lastCopy[primary]] = row;
+  lastCopy[primary] = row;
+  nextCopy[row] = -1;
+  lastCopy[row] = primary; // copies point back to their primary
+
+  pendingCopies.push_back(std::make_pair(copy, row));
+  return row;
+}
+
+inline void PIIEventRecord::AssignCopy(const G4Track* copy, G4int trackID) {
+  for (size_t p = pendingCopies.size(); p-- > 0; ) {
+    if (pendingCopies[p].first != copy) continue;
+
+    size_t c = trackID - nPhotons - 1;
+    if (trackID > nPhotons) {
+      if (c >= copyRows.size()) copyRows.resize(c + 1, -1);
+      copyRows[c] = pendingCopies[p].second;
+    }
+    pendingCopies.erase(pendingCopies.begin() + p);
+    return;
+  }
+}
+
+inline void PIIEventRecord::SetHit(G4int trackID, G4int PMTno, G4double hitTime) {
+  G4int row = Row(trackID);
+  if (row < 0) return;
+  flag[row] = 1;
+  pmt[row] = PMTno;
+  time[row] = hitTime;
+}
+
+inline void PIIEventRecord::SetFlag(G4int trackID, G4int fate) {
+  G4int row = Row(trackID);
+  if (row < 0) return;
+  flag[row] = fate;
+}
+
+inline void PIIEventRecord::SetWeight(G4int trackID, G4double trackWeight) {
+  G4int row = Row(trackID);
+  if (row < 0) return;
+  weight[row] = trackWeight;
+}
+
+inline void PIIEventRecord::AddScintPath(G4int trackID, G4double length) {
+  G4int row = Row(trackID);
+  if (row < 0) return;
+  scintPath[row] += length;
+}
+
+// Only the skins with a REFLECTIVITY are counted, by the role of their volume
+inline void PIIEventRecord::AddBounce(G4int trackID, G4int role) {
+  G4int row = Row(trackID);
+  if (row < 0) return;
+  if (role == kReflectorVolume) reflectorBounces[row]++;
+  else if (role == kLightGuideVolume) guideBounces[row]++;
+  else if (role == kTabVolume) tabBounces[row]++;
+}
+
+inline void PIIEventRecord::AddDepth(G4int trackID, G4bool scint, G4double depth) {
+  G4int row = Row(trackID);
+  if (row < 0) return;
+  if (scint) scintDepth[row] += depth;
+  else oilDepth[row] += depth;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,83 @@
+/// \file PIIFateAccumulable.hh
+/// \brief Definition of the PIIFateAccumulable class
+
+#ifndef PIIFateAccumulable_h
+#define PIIFateAccumulable_h 1
+
+#include "G4VAccumulable.hh"
+#include "PIIDetectorConstruction.hh"
+#include "globals.hh"
+
+/// Where optical photons spend their steps and how their tracks end.
+///
+/// Per volume role: tracking steps, reflections at the surface of the volume,
+/// absorptions at that surface and absorptions in the bulk. Per fate: number
+/// of photons and their total number of reflections.
+///
+/// The stepping action of each thread fills a plain instance, which the run
+/// action adds into its registered instance at the end of the run; the master
+/// prints the merged table.
+
+class PIIFateAccumulable : public G4VAccumulable
+{
+  public:
+    enum Fate {
+      kDetected = 0,      // reached a PMT cathode
+      kHousing,           // killed in a PMT housing
+      kBulkAbsorbed,      // OpAbsorption inside a volume
+      kSurfaceAbsorbed,   // absorbed at a boundary
+      kEscaped,           // left the world
+      kRouletted,         // lost the Russian roulette of /PII/bias/
+      kOtherFate,         // killed by anything else (fast model, light map)
+      kNbOfFates
+    };
+
+    PIIFateAccumulable(const G4String& name);
+    virtual ~PIIFateAccumulable();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    void AddStep(G4int role);
+    void AddReflection(G4int role);
+    void AddSurfaceAbsorption(G4int role);
+    void AddBulkAbsorption(G4int role);
+    void AddFate(G4int fate, G4int bounces);
+
+    void Print() const;
+
+  private:
+    G4long fSteps[kNbOfVolumeRoles];
+    G4long fReflections[kNbOfVolumeRoles];
+    G4long fSurfaceAbsorptions[kNbOfVolumeRoles];
+    G4long fBulkAbsorptions[kNbOfVolumeRoles];
+    G4long fFates[kNbOfFates];
+    G4long fBounces[kNbOfFates];
+};
+
+// inline functions
+
+inline void PIIFateAccumulable::AddStep(G4int role) {
+  fSteps[role]++;
+}
+
+inline void PIIFateAccumulable::AddReflection(G4int role) {
+  fReflections[role]++;
+}
+
+inline void PIIFateAccumulable::AddSurfaceAbsorption(G4int role) {
+  fSurfaceAbsorptions[role]++;
+}
+
+inline void PIIFateAccumulable::AddBulkAbsorption(G4int role) {
+  fBulkAbsorptions[role]++;
+}
+
+inline void PIIFateAccumulable::AddFate(G4int fate, G4int bounces) {
+  fFates[fate]++;
+  fBounces[fate] += bounces;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,64 @@
+/// \file PIIHitsAccumulable.hh
+/// \brief Definition of the PIIHitsAccumulable class
+
+#ifndef PIIHitsAccumulable_h
+#define PIIHitsAccumulable_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Run-level per-PMT hit counter, with the sum and sum of squares of the
+/// hit times for the mean and spread of the arrival time. Hits are sums of
+/// photon weights, which are 1 unless tracking is biased (/PII/bias/).
+///
+/// Each thread fills its own instance; the G4AccumulableManager adds the
+/// worker counters into the master instance at the end of the run.
+
+class PIIHitsAccumulable : public G4VAccumulable
+{
+  public:
+    PIIHitsAccumulable(const G4String& name);
+    virtual ~PIIHitsAccumulable();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    void  SetNoPMT(G4int nbOfPMTs);
+    G4int GetNoPMT() const;
+    void  AddHits(G4int PMTno, G4double hits);
+    G4double GetHits(G4int PMTno) const;
+    void  AddTimes(G4int PMTno, G4double timeSum, G4double timeSum2);
+    G4double GetMeanTime(G4int PMTno) const;
+    G4double GetRmsTime(G4int PMTno) const;
+
+  private:
+    std::vector<G4double> fHits;
+    std::vector<G4double> fTimeSum;
+    std::vector<G4double> fTimeSum2;
+};
+
+// inline functions
+
+inline G4int PIIHitsAccumulable::GetNoPMT() const {
+  return fHits.size();
+}
+
+inline void PIIHitsAccumulable::AddHits(G4int PMTno, G4double hits) {
+  fHits[PMTno] += hits;
+}
+
+inline G4double PIIHitsAccumulable::GetHits(G4int PMTno) const {
+  return fHits[PMTno];
+}
+
+inline void PIIHitsAccumulable::AddTimes(G4int PMTno, G4double timeSum,
+                                         G4double timeSum2) {
+  fTimeSum[PMTno] += timeSum;
+  fTimeSum2[PMTno] += timeSum2;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,84 @@
+/// \file PIILightMap.hh
+/// \brief Definition of the PIILightMap class
+
+#ifndef PIILightMap_h
+#define PIILightMap_h 1
+
+#include "G4VAccumulable.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Optical light-response map of one segment.
+///
+/// The map divides a box into (x, y, z) cells and counts, for photons started
+/// in each cell, how many reached each PMT and when, in a histogram with one
+/// extra bin for times past the last edge. A generation run fills it like any
+/// other accumulable and the master writes the merged map to a versioned
+/// binary file. Under biased tracking hits carry the photon weight, and split
+/// copies add hits without counting as started photons. In fast mode the map
+/// is read back once, shared by all threads, and SampleHit() draws the PMT
+/// and arrival time of a photon from the trilinear interpolation between cell
+/// centres.
+
+class PIILightMap : public G4VAccumulable
+{
+  public:
+    PIILightMap(const G4String& name);
+    virtual ~PIILightMap();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    void   SetGrid(G4int nx, G4int ny, G4int nz,
+                   const G4ThreeVector& lower, const G4ThreeVector& upper,
+                   G4int nbOfPMTs, G4int nbOfTimeBins, G4double timeMax);
+    void   Fill(const G4ThreeVector& pos, G4int PMTno, G4double time,
+                 G4double weight = 1., G4bool started = true);
+    G4int  SampleHit(const G4ThreeVector& pos, G4double& time) const;
+
+    G4bool Write(const G4String& fileName) const;
+    G4bool Read(const G4String& fileName);
+
+    G4int  GetNoPMT() const;
+    G4bool IsEmpty() const;
+
+    static const PIILightMap* LoadShared(const G4String& fileName);
+
+  private:
+    G4int  GetCell(const G4ThreeVector& pos) const;
+    size_t GetBin(G4int cell, G4int PMTno, G4int timeBin) const;
+    void   SumHits();
+
+    G4int fNx;
+    G4int fNy;
+    G4int fNz;
+    G4int fNbOfPMTs;
+    G4int fNbOfTimeBins;
+    G4ThreeVector fLower;
+    G4ThreeVector fUpper;
+    G4double fTimeMax;
+
+    std::vector<G4double> fStarted; // photons started per cell
+    std::vector<G4double> fHits;    // per cell, PMT and time bin
+    std::vector<G4double> fTotals;  // per cell and PMT, filled on Read()
+};
+
+// inline functions
+
+inline G4int PIILightMap::GetNoPMT() const {
+  return fNbOfPMTs;
+}
+
+inline G4bool PIILightMap::IsEmpty() const {
+  return fStarted.empty();
+}
+
+inline size_t PIILightMap::GetBin(G4int cell, G4int PMTno, G4int timeBin) const {
+  return ((size_t)cell * fNbOfPMTs + PMTno) * (fNbOfTimeBins + 1) + timeBin;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,50 @@
+/// \file PIILightMapMessenger.hh
+/// \brief Definition of the PIILightMapMessenger class
+
+#ifndef PIILightMapMessenger_h
+#define PIILightMapMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PIIRunAction;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADoubleAndUnit;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Messenger class that defines the light map commands of PIIRunAction.
+///
+/// It implements commands:
+/// - /PII/lightmap/generate file
+/// - /PII/lightmap/fast file
+/// - /PII/lightmap/xyBins n
+/// - /PII/lightmap/zBins n
+/// - /PII/lightmap/timeBins n
+/// - /PII/lightmap/timeMax value unit
+
+class PIILightMapMessenger: public G4UImessenger
+{
+  public:
+    PIILightMapMessenger(PIIRunAction*);
+    virtual ~PIILightMapMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    PIIRunAction*              fRunAction;
+
+    G4UIdirectory*             fLightMapDirectory;
+    G4UIcmdWithAString*        fGenerateCmd;
+    G4UIcmdWithAString*        fFastCmd;
+    G4UIcmdWithAnInteger*      fXYBinsCmd;
+    G4UIcmdWithAnInteger*      fZBinsCmd;
+    G4UIcmdWithAnInteger*      fTimeBinsCmd;
+    G4UIcmdWithADoubleAndUnit* fTimeMaxCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,29 @@
+/// \file PIIOpticalPhysicsList.hh
+/// \brief Definition of the PIIOpticalPhysicsList class
+
+#ifndef PIIOpticalPhysicsList_h
+#define PIIOpticalPhysicsList_h 1
+
+#include "G4VModularPhysicsList.hh"
+#include "globals.hh"
+
+/// Minimal physics list for runs with optical photon primaries only
+/// (PII --physics optical).
+///
+/// Transportation plus the optical processes photons need in this detector:
+/// bulk absorption, boundary processes and Rayleigh scattering. Cerenkov,
+/// scintillation, Mie and WLS are switched off and no hadronic physics is
+/// built, which keeps startup time and memory low. Standard EM is kept for
+/// the particles the production cuts need. Rayleigh scattering can be
+/// switched off with /process/optical/processActivation OpRayleigh false.
+
+class PIIOpticalPhysicsList : public G4VModularPhysicsList
+{
+  public:
+    PIIOpticalPhysicsList();
+    virtual ~PIIOpticalPhysicsList();
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
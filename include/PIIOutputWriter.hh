@@ -0,0 +1,80 @@
+/// \file PIIOutputWriter.hh
+/// \brief Definition of the PIIOutputWriter class
+
+#ifndef PIIOutputWriter_h
+#define PIIOutputWriter_h 1
+
+#include "globals.hh"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+class G4VAnalysisManager;
+
+/// One ntuple row. Integer columns come first, then double columns, which
+/// covers the Geometry, photon (with weight and path summary) and bomb
+/// ntuples.
+
+struct PIIOutputRecord
+{
+  G4int    ntupleId;
+  G4int    nInts;
+  G4int    nDoubles;
+  G4int    ints[3];
+  G4double doubles[12];
+};
+
+/// Asynchronous ntuple writer
+///
+/// The event action of one worker pushes rows into a bounded single-producer,
+/// single-consumer ring and a writer thread drains it in batches into a
+/// temporary spill file of its own. The analysis manager of the worker is
+/// thread-local, so the writer thread never touches it: Stop() joins the
+/// writer and fills the spilled rows into the manager on the calling worker
+/// thread. When the ring is full Push() waits for the writer.
+
+class PIIOutputWriter
+{
+  public:
+    PIIOutputWriter(G4int capacity = 65536);
+    ~PIIOutputWriter();
+
+    G4bool Start();
+    void   Stop(G4VAnalysisManager* man);
+    void   Push(const PIIOutputRecord& row);
+
+    G4bool IsRunning() const;
+    G4long GetNoStalls() const;
+
+    static void Fill(G4VAnalysisManager* man, const PIIOutputRecord& row);
+
+  private:
+    void Run();
+    G4int Drain();
+
+    std::vector<PIIOutputRecord> fBuffer;
+    size_t                       fMask;
+    std::atomic<size_t>          fHead; // next slot to write, producer only
+    std::atomic<size_t>          fTail; // next slot to read, writer only
+    std::atomic<G4bool>          fRunning;
+    std::atomic<G4bool>          fFailed; // a spill write failed
+    G4long                       fStalls;
+    std::FILE*                   fSpill;  // written by the writer only
+    std::thread                  fThread;
+};
+
+// inline functions
+
+inline G4bool PIIOutputWriter::IsRunning() const {
+  return fRunning;
+}
+
+inline G4long PIIOutputWriter::GetNoStalls() const {
+  return fStalls;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
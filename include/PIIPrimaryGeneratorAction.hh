@@ -18,6 +18,19 @@ class PIIEventAction;
 /// perpendicular to the input face. The type of the particle
 /// can be changed via the G4 build-in commands of G4ParticleGun class
 /// (see the macros provided with this example).
+///
+/// Each event carries /PII/generator/photonsPerEvent photons, one primary
+/// vertex each. Distribution 3 places a new bomb every
+/// /PII/generator/bombSize photons.
+///
+/// With /PII/random/perEvent the random engine is reseeded at the start of
+/// every event from the run seed and the global event number (event ID plus
+/// /PII/random/eventOffset), and bomb positions are drawn from the bomb
+/// number, so an event does not depend on the thread or process running it.
+///
+/// With /PII/bias/direction the isotropic directions are drawn from a biased
+/// density instead, and each primary particle carries the importance weight
+/// of its direction.
 
 class PIIPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
@@ -36,6 +49,11 @@ class PIIPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
     void SetIsotropic(G4bool);
     void SetDistribution(G4int);
     void SetRandomXY(G4bool);
+    void SetPhotonsPerEvent(G4int);
+    void SetBombSize(G4int);
+    void SetRunSeed(G4long);
+    void SetEventOffset(G4long);
+    void SetPerEventSeeds(G4bool);
     void SetDefaults();
 
     // Set return methods
@@ -45,6 +63,11 @@ class PIIPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
     G4bool            GetIsotropic();
     G4int             GetDistribution();
     G4bool            GetRandomXY();
+    G4int             GetPhotonsPerEvent();
+    G4int             GetBombSize();
+    G4long            GetRunSeed();
+    G4long            GetEventOffset();
+    G4bool            GetPerEventSeeds();
 
   private:
     G4ParticleGun*  fParticleGun; // G4 particle gun
@@ -56,6 +79,11 @@ class PIIPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
     G4int           fDistrb;
     G4bool          fIsotropic;
     G4bool          fRandomXY;
+    G4int           fPhotonsPerEvent;
+    G4int           fBombSize;
+    G4long          fRunSeed;
+    G4long          fEventOffset;
+    G4bool          fPerEventSeeds;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
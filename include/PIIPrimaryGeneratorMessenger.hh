@@ -36,7 +36,13 @@ class PIIPrimaryGeneratorMessenger: public G4UImessenger
     G4UIcmdWithABool*             fIsotropicCmd;
     G4UIcmdWithAnInteger*         fDistributionCmd;
     G4UIcmdWithABool*             fRandomXYCmd;
+    G4UIcmdWithAnInteger*         fPhotonsPerEventCmd;
+    G4UIcmdWithAnInteger*         fBombSizeCmd;
     G4UIcommand*                  fDefaultsCmd;
+    G4UIdirectory*                fRandomDir;
+    G4UIcmdWithAnInteger*         fRunSeedCmd;
+    G4UIcmdWithAnInteger*         fEventOffsetCmd;
+    G4UIcmdWithABool*             fPerEventSeedsCmd;
 
 };
 
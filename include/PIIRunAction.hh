@@ -5,21 +5,43 @@
 #define PIIRunAction_h 1
 
 #include "G4UserRunAction.hh"
+#include "G4Accumulable.hh"
 #include "PIIRunMessenger.hh"
+#include "PIIHitsAccumulable.hh"
+#include "PIIFateAccumulable.hh"
+#include "PIIUniverseAccumulable.hh"
+#include "PIIBombAccumulable.hh"
+#include "PIILightMap.hh"
+#include "PIIDirectionBias.hh"
 #include "globals.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 class G4Run;
+class PIIDetectorConstruction;
 class PIISteppingAction;
 class PIIEventAction;
+class PIIOutputWriter;
+class PIIStackingAction;
+class PIILightMapMessenger;
+class PIIUniverseMessenger;
+class PIIBiasingMessenger;
+class PIIPrimaryGeneratorAction;
+class G4VAnalysisManager;
 
 /// Run action class
+///
+/// BeginOfRunAction() books the output of the run and hands the run settings
+/// to the actions of each worker. At the end of the run the workers fold
+/// their totals into accumulables, and the master, which has no event or
+/// stepping action, prints and writes the merged results.
 
 class PIIRunAction : public G4UserRunAction
 {
   public:
-    PIIRunAction(PIISteppingAction* stepAction, PIIEventAction* eventAction);
+    PIIRunAction(PIIDetectorConstruction* detConstruction,
+                 PIISteppingAction* stepAction, PIIEventAction* eventAction,
+                 PIIStackingAction* stackAction);
     virtual ~PIIRunAction();
 
     virtual void   BeginOfRunAction(const G4Run* run);
@@ -27,20 +49,119 @@ class PIIRunAction : public G4UserRunAction
     virtual void   SetDefaults();
     virtual void   SetFilename(G4String);
     virtual void   SetRunid(G4String, G4int);
+    virtual void   SetLabel(G4String);
     virtual void   SetOutputFiles(G4int);
+    virtual void   SetFormat(G4String);
+    virtual void   SetCompression(G4int);
+    virtual void   SetAsyncOutput(G4bool);
+    virtual void   SetPathSummary(G4bool);
+    virtual void   SetZBins(G4int);
+    virtual void   SetTimeBins(G4int);
+    virtual void   SetTimeMax(G4double);
+    virtual void   SetLightMapOutput(G4String);
+    virtual void   SetLightMapInput(G4String);
+    virtual void   SetLightMapXYBins(G4int);
+    virtual void   SetLightMapZBins(G4int);
+    virtual void   SetLightMapTimeBins(G4int);
+    virtual void   SetLightMapTimeMax(G4double);
+    virtual void   AddUniverse(const PIIUniverse&);
+    virtual void   ClearUniverses();
+    virtual void   SetRouletteBounces(G4int);
+    virtual void   SetRouletteLength(G4double);
+    virtual void   SetSurvival(G4double);
+    virtual void   SetSplitting(G4int);
+    virtual void   SetDirectionMode(G4int);
+    virtual void   SetConeAngle(G4double);
+    virtual void   SetConeFraction(G4double);
+    virtual void   SetDirectionMap(G4String);
+    virtual G4bool IsBiased() const;
+    virtual G4long GetNoSteps() const;
 
+    PIIDetectorConstruction* fDetConstruction;
     PIISteppingAction* fStepAction;
     PIIEventAction*    fEventAction;
+    PIIStackingAction* fStackAction;
 
     G4String filename;
     G4String fRunid;
+    G4String fLabel;
     G4int    fRunNum;
     G4int    fOutputs;
+    G4int    fCompression;
+    G4bool   fAsyncOutput;
+    G4bool   fPathSummary;
+    G4int    fZBins;
+    G4int    fTimeBins;
+    G4double fTimeMax;
+    G4String fLightMapOutput;
+    G4String fLightMapInput;   // /PII/lightmap/fast, one read-only map
+                               // shared by the stacking actions
+    G4int    fLightMapXYBins;
+    G4int    fLightMapZBins;
+    G4int    fLightMapTimeBins;
+    G4double fLightMapTimeMax;
+    std::vector<PIIUniverse> fUniverses; // /PII/universe/add
+    // Biasing of /PII/bias/: roulette and splitting for the stepping action
+    // of every worker, direction biasing of the primary photons for the
+    // generator through the event action. Tallies then sum weights.
+    G4int    fRouletteBounces;
+    G4double fRouletteLength;
+    G4double fSurvival;
+    G4int    fSplitting;
+    PIIDirectionBias fDirectionBias;
 
   private:
+    void CreatePhotonNtuple(G4VAnalysisManager* man);
+    void CreateBombNtuple(G4VAnalysisManager* man);
+    void CheckBombs() const;
+    void PrepareBombs(G4int nEvents);
+    void CheckPhotonNumbers(G4int nEvents) const;
+    PIIPrimaryGeneratorAction* GetGenerator() const;
+    void CreatePathSummaryColumns(G4VAnalysisManager* man);
+    void WriteUniverses(G4VAnalysisManager* man);
+    void WriteBombs(G4VAnalysisManager* man);
+
     PIIRunMessenger* fRunMessenger;
+    PIIOutputWriter* fOutputWriter;      // /PII/output/asyncWriter, joined and
+                                         // its rows filled in EndOfRunAction()
+    PIILightMapMessenger* fLightMapMessenger;
+    PIIUniverseMessenger* fUniverseMessenger;
+    PIIBiasingMessenger* fBiasingMessenger;
+
+    // Run totals, merged from the workers into the master
+    PIIHitsAccumulable fPMTHits;         // hits and hit time sums per PMT
+    PIILightMap fLightMap;               // /PII/lightmap/generate, written by
+                                         // the master
+    G4Accumulable<G4long> fNbOfSteps;    // tracking steps, for PII --bench
+    G4Accumulable<G4double> fNbOfDetected;
+    G4Accumulable<G4double> fNbOfHousing;
+    G4Accumulable<G4double> fNbOfLost;
+    PIIFateAccumulable fFates;           // photon fates and per-volume steps
+    PIIUniverseAccumulable fUniverseHits; // weighted hits of each universe
+    PIIBombAccumulable fBombs;           // bomb tallies by bomb number
+
+    // IDs of the output booked for the current run, -1 when not booked
+    G4int fGeometryNtuple;
+    G4int fPhotonNtuple;
+    G4int fUniverseNtuple;
+    G4int fBombNtuple;
+    G4int fSourcesH1;
+    G4int fHitsH2;
+    G4int fTimeSumH2;
+    G4int fTimesH2;                      // first of the two per-plane time H2s
 };
 
+// inline functions
+
+inline G4long PIIRunAction::GetNoSteps() const {
+  return fNbOfSteps.GetValue();
+}
+
+inline G4bool PIIRunAction::IsBiased() const {
+  return fRouletteBounces > 0 || fRouletteLength > 0. || fSplitting > 1
+         || fDirectionBias.GetMode() != PIIDirectionBias::kNone;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #endif
@@ -12,6 +12,8 @@ class PIIRunAction;
 class G4UIdirectory;
 class G4UIcmdWithAString;
 class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+class G4UIcmdWithADoubleAndUnit;
 
 class PIIRunMessenger: public G4UImessenger
 {
@@ -27,7 +29,15 @@ class PIIRunMessenger: public G4UImessenger
     G4UIdirectory*           fRunDirectory;
     G4UIcmdWithAString*      fFilenameCmd;
     G4UIcmdWithAnInteger*    fRunidCmd;
+    G4UIcmdWithAString*      fLabelCmd;
     G4UIcmdWithAnInteger*    fOutputCmd;
+    G4UIcmdWithAString*      fFormatCmd;
+    G4UIcmdWithAnInteger*    fCompressionCmd;
+    G4UIcmdWithABool*        fAsyncWriterCmd;
+    G4UIcmdWithABool*        fPathSummaryCmd;
+    G4UIcmdWithAnInteger*    fZBinsCmd;
+    G4UIcmdWithAnInteger*    fTimeBinsCmd;
+    G4UIcmdWithADoubleAndUnit* fTimeMaxCmd;
     G4UIcommand*             fDefaultsCmd;
 };
 
@@ -0,0 +1,103 @@
+/// \file PIIScintFastModel.hh
+/// \brief Definition of the PIIScintFastModel class
+
+#ifndef PIIScintFastModel_h
+#define PIIScintFastModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "G4AffineTransform.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <vector>
+
+class G4OpticalSurface;
+class G4LogicalVolume;
+class G4VSolid;
+class G4FastStep;
+
+/// Fast optical transport inside a scintillator segment.
+///
+/// The segment is a box lined with reflectors, so a photon only ever bounces
+/// between the four side walls while it travels along z. The model follows
+/// it wall to wall in one go: at each wall the photon survives with the
+/// reflector REFLECTIVITY and is reflected specularly (spike and lobe),
+/// straight back (backscatter) or diffusely (Lambertian), and the bulk
+/// ABSLENGTH is applied over the whole path and the arrival time follows
+/// from the GROUPVEL of the photon. Photons that reach a plane
+/// fHandBackDistance before an end face are handed back to normal tracking,
+/// so the window, light guides and PMTs are still fully simulated.
+///
+/// Daughters of the envelope, the corner tabs, are left to normal tracking
+/// as well: the model does not trigger inside them or within
+/// 2*fHandBackDistance of them, and hands a photon back fHandBackDistance
+/// before its path would enter one.
+///
+/// The model is switched on and off for all threads with
+/// /PII/fastsim/scintillator. It reports the wall reflections of its last
+/// step, and how the photon was lost if it killed it, so that the stepping
+/// action fills the fate tables as for full tracking.
+
+class PIIScintFastModel : public G4VFastSimulationModel
+{
+  public:
+    PIIScintFastModel(const G4String& modelName, G4Region* envelope,
+                      const G4OpticalSurface* reflector);
+    virtual ~PIIScintFastModel();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack);
+    virtual void   DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+
+    static void   SetEnabled(G4bool enabled);
+    static G4bool IsEnabled();
+
+    // Invalidates the daughter caches of all threads, for a rebuilt geometry
+    static void   NewGeometry();
+
+    // Last step of the model on this thread: wall reflections, and the
+    // PIIFateAccumulable fate of the photon if it was killed, -1 if not
+    static G4int  GetLastReflections();
+    static G4int  GetLastFate();
+
+  private:
+    // A daughter of the envelope, with its bounding box in the envelope frame
+    struct Daughter
+    {
+      const G4VSolid*   solid;
+      G4AffineTransform toLocal;
+      G4ThreeVector     min;
+      G4ThreeVector     max;
+    };
+
+    G4double GetReflectorProperty(const char* name, G4double energy,
+                                  G4double defaultValue) const;
+    void     CacheDaughters(const G4LogicalVolume* envelope);
+    G4bool   NearDaughter(const G4ThreeVector& pos, G4double distance) const;
+    G4double DistanceToDaughter(const G4ThreeVector& pos, const G4ThreeVector& dir,
+                                G4double maxDistance) const;
+    void     HandBack(const G4Track* track, const G4ThreeVector& pos,
+                      const G4ThreeVector& dir, G4ThreeVector polar,
+                      G4double path, G4double groupVel, G4FastStep& fastStep) const;
+
+    const G4OpticalSurface* fReflector;
+    G4double fHandBackDistance;
+    G4int    fMaxBounces;
+
+    // Daughters of the envelope the cache was built for, per thread as the
+    // model is. The envelope is identified by its instance ID and the
+    // geometry generation, as a rebuilt geometry may reuse its address.
+    G4int                  fCachedEnvelopeID;
+    G4int                  fCachedGeneration;
+    std::vector<Daughter>  fDaughters;
+
+    static std::atomic<G4bool> fEnabled;
+    static std::atomic<G4int>  fGeneration;
+    static G4ThreadLocal G4int fLastReflections;
+    static G4ThreadLocal G4int fLastFate;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
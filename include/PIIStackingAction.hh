@@ -0,0 +1,51 @@
+/// \file PIIStackingAction.hh
+/// \brief Definition of the PIIStackingAction class
+
+#ifndef PIIStackingAction_h
+#define PIIStackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class PIIDetectorConstruction;
+class PIIEventAction;
+class PIILightMap;
+
+/// Stacking action class
+///
+/// In light-map fast mode optical photons are never tracked: the PMT hit
+/// and arrival time of each primary photon are sampled from the map and
+/// handed to the event action, and the photon is killed. The map covers the
+/// segment at the origin, so photons are sampled at their position relative
+/// to their own segment and the PMT is shifted by as many rows and columns.
+/// Photons split by the stepping action (/PII/bias/splitting) are matched
+/// here to the rows the event action made for them, by their new track ID.
+
+class PIIStackingAction : public G4UserStackingAction
+{
+  public:
+    PIIStackingAction(PIIDetectorConstruction* detConstruction,
+                      PIIEventAction* eventAction);
+    virtual ~PIIStackingAction();
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+
+    void SetLightMap(const PIILightMap* map);
+
+  private:
+    G4int ShiftPMT(G4int PMTno, G4int segment) const;
+
+    PIIDetectorConstruction* fDetConstruction;
+    PIIEventAction*          fEventAction;
+    const PIILightMap*       fLightMap;
+};
+
+// inline functions
+
+inline void PIIStackingAction::SetLightMap(const PIILightMap* map) {
+  fLightMap = map;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
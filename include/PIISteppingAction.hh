@@ -7,16 +7,29 @@
 #include "G4UserSteppingAction.hh"
 #include "G4Allocator.hh"
 #include "G4Types.hh"
+#include "G4MaterialPropertyVector.hh"
 #include "tls.hh"
 
+#include "PIIFateAccumulable.hh"
+
 class PIIDetectorConstruction;
 class PIIEventAction;
+class G4OpBoundaryProcess;
 
 /// Stepping action class.
 ///
-/// In UserSteppingAction() there are collected the energy deposit and track
-/// lengths of charged particles in Absober and Gap layers and
-/// updated in PIIEventAction.
+/// UserSteppingAction() classifies each step by the role of its volume,
+/// kills photons entering a PMT housing and flags lost photons in
+/// PIIEventAction. It also counts steps per volume, reflections and
+/// absorptions per surface, and the fate and bounce count of every photon
+/// in this thread's PIIFateAccumulable. The path summary and, with
+/// universes, the optical depths of each photon go to PIIEventAction.
+///
+/// With biasing (/PII/bias/) photons play Russian roulette each time their
+/// reflections or path length pass a threshold, and primary photons are
+/// split into copies of lower weight as they cross the outer face of an end
+/// window towards a light guide. The weight of every photon goes to
+/// PIIEventAction when its track ends, zero for a photon lost at roulette.
 
 class PIISteppingAction : public G4UserSteppingAction
 {
@@ -26,10 +39,32 @@ public:
 
   virtual void UserSteppingAction(const G4Step* step);
 
+  G4long GetNoSteps() const { return fNbOfSteps; };
+  void   ResetNoSteps()     { fNbOfSteps = 0; fFates.Reset(); };
+  const PIIFateAccumulable& GetFates() const { return fFates; };
+  void   SetBiasing(G4int rouletteBounces, G4double rouletteLength,
+                    G4double survival, G4int splitting);
 
 private:
+  G4bool ApplyBiasing(const G4Step* step);
+
   const PIIDetectorConstruction* fDetConstruction;
   PIIEventAction* fEventAction;
+  G4long fNbOfSteps; // steps of this thread in the current run
+  PIIFateAccumulable fFates;
+  G4OpBoundaryProcess* fBoundary; // this thread's boundary process
+  G4int fBounces;                 // reflections of the current track
+  G4MaterialPropertyVector* fScintAbsLength; // ABSLENGTH tables, for
+  G4MaterialPropertyVector* fOilAbsLength;   // the universe weights
+
+  // Biasing settings of the run, and the state of the current track
+  G4int    fRouletteBounces;  // reflections between roulettes, 0 for none
+  G4double fRouletteLength;   // path length between roulettes, 0 for none
+  G4double fSurvival;         // survival probability of a roulette
+  G4int    fSplitting;        // copies per split photon, 1 for none
+  G4int    fNextBounces;      // reflections at the next roulette
+  G4double fNextLength;       // path length at the next roulette
+  G4bool   fSplit;            // current track has been split
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
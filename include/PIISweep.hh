@@ -0,0 +1,77 @@
+/// \file PIISweep.hh
+/// \brief Definition of the PIISweep class
+
+#ifndef PIISweep_h
+#define PIISweep_h 1
+
+#include "globals.hh"
+
+#include <map>
+#include <vector>
+
+class PIISweepMessenger;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// In-process parameter sweep over geometry, generator and output settings.
+///
+/// A sweep file lists the parameter points, each as a label followed by the
+/// UI commands that set it:
+///
+///     # window thickness scan
+///     events 10000
+///     /PII/generator/distribution 2
+///     point w0635
+///     /PII/det/windowThickness 0.635 cm
+///     point w1270
+///     /PII/det/windowThickness 1.27 cm
+///     events 20000
+///
+/// Commands before the first point are applied once for all of them, an
+/// "events" line sets the number of events of the following points or, after
+/// a point line, of that point only. The points run one after the other as
+/// runs of the initialized kernel, each on all worker threads and with its
+/// label as output label (/PII/output/label).
+///
+/// A command is only applied when its text differs from the one last applied
+/// for the same command, so a point that only moves the source keeps the
+/// geometry, physics tables and output setup of the point before. Settings
+/// stay in effect until a later point changes them.
+
+class PIISweep
+{
+  public:
+    PIISweep();
+    virtual ~PIISweep();
+
+    void Run(const G4String& fileName);
+    void SetNoEvents(G4int events);
+
+  private:
+    struct Point
+    {
+      G4String              label;
+      std::vector<G4String> commands;
+      G4int                 events;
+    };
+
+    G4bool Parse(const G4String& fileName, std::vector<G4String>& common,
+                 std::vector<Point>& points) const;
+    G4bool Apply(const G4String& command);
+
+    PIISweepMessenger* fSweepMessenger;
+    G4int              fNbOfEvents;
+
+    // Last command applied during the sweep, keyed by command path
+    std::map<G4String, G4String> fApplied;
+};
+
+// inline functions
+
+inline void PIISweep::SetNoEvents(G4int events) {
+  fNbOfEvents = events;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
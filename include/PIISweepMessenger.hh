@@ -0,0 +1,41 @@
+/// \file PIISweepMessenger.hh
+/// \brief Definition of the PIISweepMessenger class
+
+#ifndef PIISweepMessenger_h
+#define PIISweepMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PIISweep;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Messenger class that defines the commands of PIISweep.
+///
+/// It implements commands:
+/// - /PII/sweep/run file
+/// - /PII/sweep/events n
+
+class PIISweepMessenger: public G4UImessenger
+{
+  public:
+    PIISweepMessenger(PIISweep*);
+    virtual ~PIISweepMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    PIISweep*             fSweep;
+
+    G4UIdirectory*        fSweepDirectory;
+    G4UIcmdWithAString*   fRunCmd;
+    G4UIcmdWithAnInteger* fEventsCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
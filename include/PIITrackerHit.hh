@@ -10,11 +10,11 @@
 #include "G4ThreeVector.hh"
 #include "tls.hh"
 
-/// Tracker hit class
+/// PMT hit class
 ///
-/// It defines data members to store the trackID, PMTNb, energy deposit,
-/// and position of charged particles in a selected volume:
-/// - fTrackID, fPMTNb, fEdep, fPos
+/// One hit per optical photon detected on a PMT cathode. It stores the
+/// trackID, PMT number, arrival time, position and wavelength of the photon:
+/// - fTrackID, fPMTNb, fTime, fPos, fWavelength
 
 class PIITrackerHit : public G4VHit
 {
@@ -35,23 +35,26 @@ class PIITrackerHit : public G4VHit
     virtual void Print();
 
     // Set methods
-    void SetTrackID  (G4int track)      { fTrackID = track; };
-    void SetPMTNb    (G4int pmtn)       { fPMTNb = pmtn; };
-    void SetEdep     (G4double de)      { fEdep = de; };
-    void SetPos      (G4ThreeVector xyz){ fPos = xyz; };
+    void SetTrackID   (G4int track)      { fTrackID = track; };
+    void SetPMTNb     (G4int pmtn)       { fPMTNb = pmtn; };
+    void SetTime      (G4double t)       { fTime = t; };
+    void SetPos       (G4ThreeVector xyz){ fPos = xyz; };
+    void SetWavelength(G4double lambda)  { fWavelength = lambda; };
 
     // Get methods
-    G4int GetTrackID() const     { return fTrackID; };
-    G4int GetPMTNb() const       { return fPMTNb; };
-    G4double GetEdep() const     { return fEdep; };
-    G4ThreeVector GetPos() const { return fPos; };
+    G4int GetTrackID() const       { return fTrackID; };
+    G4int GetPMTNb() const         { return fPMTNb; };
+    G4double GetTime() const       { return fTime; };
+    G4ThreeVector GetPos() const   { return fPos; };
+    G4double GetWavelength() const { return fWavelength; };
 
   private:
 
       G4int         fTrackID;
       G4int         fPMTNb;
-      G4double      fEdep;
+      G4double      fTime;
       G4ThreeVector fPos;
+      G4double      fWavelength;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -12,14 +12,16 @@
 
 class G4Step;
 class G4HCofThisEvent;
+class G4VTouchable;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 /// PIITracker sensitive detector class
 ///
-/// The hits are accounted in hits in ProcessHits() function which is called
-/// by Geant4 kernel at each step. A hit is created with each step with non zero
-/// energy deposit.
+/// Attached to the PMT cathodes (PMTBulb) on each worker thread. An optical
+/// photon entering a cathode is counted as detected: ProcessHits() creates
+/// one hit with its PMT number, time, position and wavelength and stops the
+/// track. Other particles are ignored.
 
 class PIITrackerSD : public G4VSensitiveDetector
 {
@@ -34,6 +36,8 @@ class PIITrackerSD : public G4VSensitiveDetector
     virtual void   EndOfEvent(G4HCofThisEvent* hitCollection);
 
   private:
+    G4int GetPMTNumber(const G4VTouchable* touchable) const;
+
     PIITrackerHitsCollection* fHitsCollection;
 };
 
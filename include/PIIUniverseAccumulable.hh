@@ -0,0 +1,108 @@
+/// \file PIIUniverseAccumulable.hh
+/// \brief Definition of the PIIUniverseAccumulable class
+
+#ifndef PIIUniverseAccumulable_h
+#define PIIUniverseAccumulable_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// One alternate set of optical parameters, as scale factors of the values
+/// of PIIDetectorConstruction::DefineMaterials().
+
+struct PIIUniverse
+{
+  G4String name;
+  G4double reflectorScale; // REFLECTIVITY of surfOpt
+  G4double guideScale;     // REFLECTIVITY of surfLightG
+  G4double tabScale;       // REFLECTIVITY of tabMatSurf
+  G4double scintAbsScale;  // ABSLENGTH of ScintMat
+  G4double oilAbsScale;    // ABSLENGTH of the mineral oil
+};
+
+/// Weighted per-PMT hits of each universe, from the photons of the nominal
+/// simulation.
+///
+/// The weight of a photon in a universe is the ratio of the probabilities of
+/// its path there and in the nominal simulation: the reflectivity scale of a
+/// skin for every reflection off it, and exp(-d (1/s - 1)) for an optical
+/// depth d (path over ABSLENGTH) in a material whose absorption length is
+/// scaled by s. All these factors are products, so AddPhoton() applies them
+/// once per detected photon from its path summary, in log space, as the same
+/// few operations on contiguous arrays of one number per universe. The weight
+/// of a photon from biased tracking multiplies its universe weights.
+///
+/// Each thread fills its own instance; the G4AccumulableManager adds the
+/// worker tallies into the master instance at the end of the run.
+
+class PIIUniverseAccumulable : public G4VAccumulable
+{
+  public:
+    PIIUniverseAccumulable(const G4String& name);
+    virtual ~PIIUniverseAccumulable();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    void  SetUniverses(const std::vector<PIIUniverse>& universes, G4int nbOfPMTs);
+    G4int GetNoUniverses() const;
+    G4int GetNoPMT() const;
+
+    void  AddPhotons(G4int photons);
+    void  AddPhoton(G4int PMTno, G4int reflectorBounces, G4int guideBounces,
+                    G4int tabBounces, G4double scintDepth, G4double oilDepth,
+                    G4double photonWeight = 1.);
+
+    G4long   GetNoPhotons() const;
+    G4double GetHits(G4int universe, G4int PMTno) const;
+    G4double GetDetected(G4int universe) const;
+    G4double GetDetectedError(G4int universe) const;
+
+  private:
+    G4int fNbOfPMTs;
+    G4long fNbOfPhotons;
+
+    // Per universe, in log space
+    std::vector<G4double> fLogReflector;
+    std::vector<G4double> fLogGuide;
+    std::vector<G4double> fLogTab;
+    std::vector<G4double> fScintAbs; // 1/scale - 1
+    std::vector<G4double> fOilAbs;
+    std::vector<G4double> fWeights;  // scratch, weights of the current photon
+
+    std::vector<G4double> fHits;     // universe*nbOfPMTs + PMT
+    std::vector<G4double> fSumW;     // per universe, all PMTs
+    std::vector<G4double> fSumW2;
+};
+
+// inline functions
+
+inline G4int PIIUniverseAccumulable::GetNoUniverses() const {
+  return fSumW.size();
+}
+
+inline G4int PIIUniverseAccumulable::GetNoPMT() const {
+  return fNbOfPMTs;
+}
+
+inline void PIIUniverseAccumulable::AddPhotons(G4int photons) {
+  fNbOfPhotons += photons;
+}
+
+inline G4long PIIUniverseAccumulable::GetNoPhotons() const {
+  return fNbOfPhotons;
+}
+
+inline G4double PIIUniverseAccumulable::GetHits(G4int universe, G4int PMTno) const {
+  return fHits[universe*fNbOfPMTs + PMTno];
+}
+
+inline G4double PIIUniverseAccumulable::GetDetected(G4int universe) const {
+  return fSumW[universe];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
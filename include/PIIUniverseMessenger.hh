@@ -0,0 +1,40 @@
+/// \file PIIUniverseMessenger.hh
+/// \brief Definition of the PIIUniverseMessenger class
+
+#ifndef PIIUniverseMessenger_h
+#define PIIUniverseMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PIIRunAction;
+class G4UIdirectory;
+class G4UIcommand;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Messenger class that defines the universe commands of PIIRunAction.
+///
+/// It implements commands:
+/// - /PII/universe/add name reflector guide tab scintAbs oilAbs
+/// - /PII/universe/clear
+
+class PIIUniverseMessenger: public G4UImessenger
+{
+  public:
+    PIIUniverseMessenger(PIIRunAction*);
+    virtual ~PIIUniverseMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    PIIRunAction*   fRunAction;
+
+    G4UIdirectory*  fUniverseDirectory;
+    G4UIcommand*    fAddCmd;
+    G4UIcommand*    fClearCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
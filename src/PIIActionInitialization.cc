@@ -8,11 +8,12 @@
 #include "PIIRunMessenger.hh"
 #include "PIIEventAction.hh"
 #include "PIISteppingAction.hh"
+#include "PIIStackingAction.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-PIIActionInitialization::PIIActionInitialization(PIIDetectorConstruction* detConstruction, PIIEventAction* eventAction, PIISteppingAction* stepAction)
- : G4VUserActionInitialization(), fDetConstruction(detConstruction), fEventAction(eventAction), fStepAction(stepAction)
+PIIActionInitialization::PIIActionInitialization(PIIDetectorConstruction* detConstruction)
+ : G4VUserActionInitialization(), fDetConstruction(detConstruction)
 {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -24,17 +25,22 @@ PIIActionInitialization::~PIIActionInitialization()
 
 void PIIActionInitialization::BuildForMaster() const
 {
-  SetUserAction(new PIIRunAction(fStepAction, fEventAction));
+  SetUserAction(new PIIRunAction(fDetConstruction, 0, 0, 0));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void PIIActionInitialization::Build() const
 {
-  SetUserAction(new PIIPrimaryGeneratorAction(fEventAction));
-  SetUserAction(new PIIRunAction(fStepAction, fEventAction));
-  SetUserAction(fEventAction);
-  SetUserAction(fStepAction);
+  auto eventAction = new PIIEventAction(fDetConstruction);
+  auto stepAction = new PIISteppingAction(fDetConstruction, eventAction);
+  auto stackAction = new PIIStackingAction(fDetConstruction, eventAction);
+
+  SetUserAction(new PIIPrimaryGeneratorAction(eventAction));
+  SetUserAction(new PIIRunAction(fDetConstruction, stepAction, eventAction, stackAction));
+  SetUserAction(eventAction);
+  SetUserAction(stepAction);
+  SetUserAction(stackAction);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,91 @@
+/// \file PIIAnalysis.cc
+/// \brief Implementation of the PIIAnalysis class
+
+#include "PIIAnalysis.hh"
+
+#include "G4CsvAnalysisManager.hh"
+#include "G4RootAnalysisManager.hh"
+#include "G4XmlAnalysisManager.hh"
+#include "G4Threading.hh"
+#include "G4ios.hh"
+
+namespace {
+  enum { kCsvFormat, kRootFormat, kXmlFormat };
+}
+
+G4ThreadLocal G4VAnalysisManager* PIIAnalysis::fManager = nullptr;
+G4ThreadLocal G4int PIIAnalysis::fFormat = kCsvFormat;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VAnalysisManager* PIIAnalysis::Instance()
+{
+  if (fManager) return fManager;
+
+  if (fFormat == kRootFormat) {
+    G4RootAnalysisManager* rootManager = G4RootAnalysisManager::Instance();
+
+    // Write one file with the worker ntuples merged instead of one per thread
+    if (G4Threading::IsMultithreadedApplication()) {
+      rootManager->SetNtupleMerging(true);
+    }
+    fManager = rootManager;
+  }
+  else if (fFormat == kXmlFormat) {
+    fManager = G4XmlAnalysisManager::Instance();
+  }
+  else {
+    fManager = G4CsvAnalysisManager::Instance();
+  }
+
+  return fManager;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIIAnalysis::SetFormat(const G4String& format)
+{
+  G4int newFormat;
+
+  if (format == "csv") {
+    newFormat = kCsvFormat;
+  }
+  else if (format == "root") {
+    newFormat = kRootFormat;
+  }
+  else if (format == "xml") {
+    newFormat = kXmlFormat;
+  }
+  else {
+    G4cerr << "Unknown output format " << format << ", keeping "
+           << GetFormat() << G4endl;
+    return false;
+  }
+
+  // A different backend needs its own manager, created on the next Instance()
+  if (newFormat != fFormat) {
+    DeleteInstance();
+    fFormat = newFormat;
+  }
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PIIAnalysis::GetFormat()
+{
+  if (fFormat == kRootFormat) return "root";
+  if (fFormat == kXmlFormat) return "xml";
+  return "csv";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIAnalysis::DeleteInstance()
+{
+  delete fManager;
+  fManager = nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
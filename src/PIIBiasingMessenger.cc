@@ -0,0 +1,153 @@
+/// \file PIIBiasingMessenger.cc
+/// \brief Implementation of the PIIBiasingMessenger class
+
+#include "PIIBiasingMessenger.hh"
+#include "PIIRunAction.hh"
+#include "PIIDirectionBias.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIBiasingMessenger::PIIBiasingMessenger(PIIRunAction* runner)
+ : fRunAction(runner)
+{
+  fBiasDirectory = new G4UIdirectory("/PII/bias/");
+  fBiasDirectory->SetGuidance("Russian roulette and splitting of optical photons, and");
+  fBiasDirectory->SetGuidance("biased directions of the primary photons.");
+  fBiasDirectory->SetGuidance("Photons then carry weights, which every PMT tally adds up,");
+  fBiasDirectory->SetGuidance("and the photon and bomb ntuples get weight columns.");
+  fBiasDirectory->SetGuidance("Needs full tracking, /PII/fastsim/scintillator false.");
+
+  fRouletteBouncesCmd = new G4UIcmdWithAnInteger("/PII/bias/rouletteBounces", this);
+  fRouletteBouncesCmd->SetGuidance("Play Russian roulette every given number of reflections.");
+  fRouletteBouncesCmd->SetGuidance("Default value is 0, for no roulette.");
+  fRouletteBouncesCmd->SetParameterName("rouletteBounces", true);
+  fRouletteBouncesCmd->SetDefaultValue(0);
+  fRouletteBouncesCmd->SetRange("rouletteBounces >= 0");
+  fRouletteBouncesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRouletteLengthCmd = new G4UIcmdWithADoubleAndUnit("/PII/bias/rouletteLength", this);
+  fRouletteLengthCmd->SetGuidance("Play Russian roulette every given path length.");
+  fRouletteLengthCmd->SetGuidance("Default value is 0 m, for no roulette.");
+  fRouletteLengthCmd->SetParameterName("rouletteLength", true);
+  fRouletteLengthCmd->SetDefaultValue(0.);
+  fRouletteLengthCmd->SetDefaultUnit("m");
+  fRouletteLengthCmd->SetRange("rouletteLength >= 0.");
+  fRouletteLengthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fSurvivalCmd = new G4UIcmdWithADouble("/PII/bias/survival", this);
+  fSurvivalCmd->SetGuidance("Set probability of surviving a roulette.");
+  fSurvivalCmd->SetGuidance("Survivors carry their weight divided by it.");
+  fSurvivalCmd->SetGuidance("Default value is 0.5.");
+  fSurvivalCmd->SetParameterName("survival", true);
+  fSurvivalCmd->SetDefaultValue(0.5);
+  fSurvivalCmd->SetRange("survival > 0. && survival <= 1.");
+  fSurvivalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fSplittingCmd = new G4UIcmdWithAnInteger("/PII/bias/splitting", this);
+  fSplittingCmd->SetGuidance("Split primary photons leaving the tank through an end window,");
+  fSplittingCmd->SetGuidance("towards the light guides, into copies of the given number.");
+  fSplittingCmd->SetGuidance("The split happens at the outer face of the window, where the");
+  fSplittingCmd->SetGuidance("light guide opening starts, not on entry into the guide volume.");
+  fSplittingCmd->SetGuidance("Copies share the weight of the photon and its row number.");
+  fSplittingCmd->SetGuidance("Default value is 1, for no splitting.");
+  fSplittingCmd->SetParameterName("splitting", true);
+  fSplittingCmd->SetDefaultValue(1);
+  fSplittingCmd->SetRange("splitting >= 1");
+  fSplittingCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fDirectionCmd = new G4UIcmdWithAString("/PII/bias/direction", this);
+  fDirectionCmd->SetGuidance("Set how isotropic primary photons are given their direction.");
+  fDirectionCmd->SetGuidance("none draws them isotropically.");
+  fDirectionCmd->SetGuidance("cones sends coneFraction of them into cones around +z and -z.");
+  fDirectionCmd->SetGuidance("map draws cos(theta) from the bins of /PII/bias/directionMap.");
+  fDirectionCmd->SetGuidance("Each photon carries the ratio of the isotropic density to the");
+  fDirectionCmd->SetGuidance("density it was drawn from as its weight.");
+  fDirectionCmd->SetGuidance("Default value is none.");
+  fDirectionCmd->SetParameterName("direction", true);
+  fDirectionCmd->SetDefaultValue("none");
+  fDirectionCmd->SetCandidates("none cones map");
+  fDirectionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fConeAngleCmd = new G4UIcmdWithADoubleAndUnit("/PII/bias/coneAngle", this);
+  fConeAngleCmd->SetGuidance("Set half-angle of the cones of /PII/bias/direction cones.");
+  fConeAngleCmd->SetGuidance("Up to 180 deg, cones wider than 90 deg overlap around the");
+  fConeAngleCmd->SetGuidance("xy plane and the importance weights account for both.");
+  fConeAngleCmd->SetGuidance("Default value is 30 deg.");
+  fConeAngleCmd->SetParameterName("coneAngle", true);
+  fConeAngleCmd->SetDefaultValue(30.);
+  fConeAngleCmd->SetDefaultUnit("deg");
+  fConeAngleCmd->SetRange("coneAngle > 0. && coneAngle <= 180.");
+  fConeAngleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fConeFractionCmd = new G4UIcmdWithADouble("/PII/bias/coneFraction", this);
+  fConeFractionCmd->SetGuidance("Set fraction of the photons sent into the cones.");
+  fConeFractionCmd->SetGuidance("The others stay isotropic, so that no direction is left out.");
+  fConeFractionCmd->SetGuidance("Default value is 0.5.");
+  fConeFractionCmd->SetParameterName("coneFraction", true);
+  fConeFractionCmd->SetDefaultValue(0.5);
+  fConeFractionCmd->SetRange("coneFraction >= 0. && coneFraction < 1.");
+  fConeFractionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fDirectionMapCmd = new G4UIcmdWithAString("/PII/bias/directionMap", this);
+  fDirectionMapCmd->SetGuidance("Read the importance map of /PII/bias/direction map.");
+  fDirectionMapCmd->SetGuidance("One positive importance per line, for equal bins of cos(theta)");
+  fDirectionMapCmd->SetGuidance("to the z axis from -1 to 1. # starts a comment.");
+  fDirectionMapCmd->SetParameterName("directionMap", false);
+  fDirectionMapCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIBiasingMessenger::~PIIBiasingMessenger()
+{
+  delete fRouletteBouncesCmd;
+  delete fRouletteLengthCmd;
+  delete fSurvivalCmd;
+  delete fSplittingCmd;
+  delete fDirectionCmd;
+  delete fConeAngleCmd;
+  delete fConeFractionCmd;
+  delete fDirectionMapCmd;
+  delete fBiasDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIBiasingMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fRouletteBouncesCmd) {
+    fRunAction->SetRouletteBounces(fRouletteBouncesCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fRouletteLengthCmd) {
+    fRunAction->SetRouletteLength(fRouletteLengthCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fSurvivalCmd) {
+    fRunAction->SetSurvival(fSurvivalCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fSplittingCmd) {
+    fRunAction->SetSplitting(fSplittingCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fDirectionCmd) {
+    G4int mode = PIIDirectionBias::kNone;
+    if (newValue == "cones") mode = PIIDirectionBias::kCones;
+    else if (newValue == "map") mode = PIIDirectionBias::kMap;
+    fRunAction->SetDirectionMode(mode);
+  }
+  else if (command == fConeAngleCmd) {
+    fRunAction->SetConeAngle(fConeAngleCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fConeFractionCmd) {
+    fRunAction->SetConeFraction(fConeFractionCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fDirectionMapCmd) {
+    fRunAction->SetDirectionMap(newValue);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
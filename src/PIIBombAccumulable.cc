@@ -0,0 +1,79 @@
+/// \file PIIBombAccumulable.cc
+/// \brief Implementation of the PIIBombAccumulable class
+
+#include "PIIBombAccumulable.hh"
+
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIBombAccumulable::PIIBombAccumulable(const G4String& name)
+ : G4VAccumulable(name, G4MergeMode::kAddition), fBombSize(0), fFirstBomb(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIBombAccumulable::~PIIBombAccumulable()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIBombAccumulable::Merge(const G4VAccumulable& other)
+{
+  const PIIBombAccumulable& otherBombs
+    = static_cast<const PIIBombAccumulable&>(other);
+
+  // The bombs of the run are only known to the workers, which all share them
+  if (otherBombs.fBombs.empty()) return;
+  if (fBombs.size() != otherBombs.fBombs.size() || fFirstBomb != otherBombs.fFirstBomb) {
+    SetBombs(otherBombs.fFirstBomb, otherBombs.fBombs.size(), otherBombs.fBombSize);
+  }
+
+  for (size_t b = 0; b < fBombs.size(); b++) {
+    const PIIBomb& otherBomb = otherBombs.fBombs[b];
+    PIIBomb& bomb = fBombs[b];
+    if (bomb.photons == 0) bomb.pos = otherBomb.pos;
+    bomb.left += otherBomb.left;
+    bomb.right += otherBomb.right;
+    bomb.photons += otherBomb.photons;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIBombAccumulable::Reset()
+{
+  std::fill(fBombs.begin(), fBombs.end(), PIIBomb());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIBombAccumulable::SetBombs(G4long firstBomb, G4long nbOfBombs, G4int bombSize)
+{
+  fFirstBomb = firstBomb;
+  fBombSize = bombSize;
+  fBombs.assign(nbOfBombs, PIIBomb());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIBombAccumulable::AddPhoton(G4long bombNo, const G4ThreeVector& pos,
+                                   G4double left, G4double right)
+{
+  size_t b = bombNo - fFirstBomb;
+  if (bombNo < fFirstBomb || b >= fBombs.size()) {
+    G4ExceptionDescription msg;
+    msg << "Bomb " << bombNo << " is outside the bombs of the run, "
+        << fFirstBomb << " to " << fFirstBomb + (G4long)fBombs.size() - 1 << ".";
+    G4Exception("PIIBombAccumulable::AddPhoton()", "PIIBomb002", FatalException, msg);
+    return;
+  }
+
+  PIIBomb& bomb = fBombs[b];
+  if (bomb.photons == 0) bomb.pos = pos;
+  bomb.left += left;
+  bomb.right += right;
+  bomb.photons++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -4,6 +4,7 @@
 #include "PIIDetectorConstruction.hh"
 #include "PIIDetectorMessenger.hh"
 #include "PIITrackerSD.hh"
+#include "PIIScintFastModel.hh"
 
 #include "G4RunManager.hh"
 
@@ -18,9 +19,15 @@
 #include "G4ExtrudedSolid.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVReplica.hh"
 #include "G4GlobalMagFieldMessenger.hh"
 #include "G4AutoDelete.hh"
 #include "G4SDManager.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4SolidStore.hh"
 
 #include "G4GeometryTolerance.hh"
 #include "G4GeometryManager.hh"
@@ -31,6 +38,8 @@
 
 #include "G4SubtractionSolid.hh"
 #include "G4IntersectionSolid.hh"
+#include "G4TessellatedSolid.hh"
+#include "G4TriangularFacet.hh"
 
 #include "G4OpticalSurface.hh"
 #include "G4LogicalSkinSurface.hh"
@@ -40,24 +49,47 @@
 #include "G4Colour.hh"
 
 #include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
 #include "G4TwoVector.hh"
+#include "Randomize.hh"
+#include "G4RandomDirection.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4ThreadLocal
 G4GlobalMagFieldMessenger* PIIDetectorConstruction::fMagFieldMessenger = 0;
 
+G4ThreadLocal
+PIIScintFastModel* PIIDetectorConstruction::fScintModel = 0;
+
 PIIDetectorConstruction::PIIDetectorConstruction()
 :G4VUserDetectorConstruction(),
+ fMaterialsDefined(false),
  fLogicReflector(NULL),
+ fWorldPV(NULL),
+ fMountPlaneZ(0.),
+ fSegmentWidth(0.),
+ fBulbInner(0.),
+ fBulbRadius(0.),
+ fBulbCut(0.),
+ fGuideWidth(0.),
  fStepLimit(NULL),
- fCheckOverlaps(true)
+ fCheckOverlaps(true),
+ fReplicate(false),
+ fPrimitiveSolids(false)
 {
   fDetMessenger = new PIIDetectorMessenger(this);
 
   SetDefaults();
 
   fLogicReflector = new G4LogicalVolume*[2];
+
+  fBulbSolid[0] = fBulbSolid[1] = NULL;
+  fGuideSolid[0] = fGuideSolid[1] = NULL;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -73,11 +105,24 @@ PIIDetectorConstruction::~PIIDetectorConstruction()
 
 G4VPhysicalVolume* PIIDetectorConstruction::Construct()
 {
-  // Define materials
+  // Define materials, once per process
   DefineMaterials();
 
+  // A rebuilt geometry replaces the volumes, solids and skin surfaces of the
+  // previous one; materials and optical surfaces are kept, so the physics
+  // tables built for them stay valid
+  if (fWorldPV) {
+    G4GeometryManager::GetInstance()->OpenGeometry();
+    G4PhysicalVolumeStore::GetInstance()->Clean();
+    G4LogicalVolumeStore::GetInstance()->Clean();
+    G4SolidStore::GetInstance()->Clean();
+    G4LogicalSkinSurface::CleanSurfaceTable();
+    PIIScintFastModel::NewGeometry();
+  }
+
   // Define volumes
-  return DefineVolumes();
+  fWorldPV = DefineVolumes();
+  return fWorldPV;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -97,6 +142,11 @@ void PIIDetectorConstruction::SetDefaults() {
 
 void PIIDetectorConstruction::DefineMaterials()
 {
+  // Materials, elements and optical surfaces are process-wide; geometry
+  // changes reuse the ones built for the first geometry
+  if (fMaterialsDefined) return;
+  fMaterialsDefined = true;
+
   // Pre-built G4 materials
   const G4int nE = 3;
   G4double photon_energies[nE] = {2.38*eV, 2.91*eV, 3.44*eV}; // range of scintillation energies used
@@ -279,6 +329,13 @@ void PIIDetectorConstruction::DefineMaterials()
 
 G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
 {
+  // Volume roles are rebuilt together with the geometry
+  fVolumeRoles.clear();
+
+  // Array counts follow /PII/det/rowNumber and /PII/det/colNumber
+  fNbOfPMTs = fRowNum*fColNum*2;
+  fNbOfReflectors = fRowNum*(fColNum + 1) + fColNum*(fRowNum + 1);
+
   // Defining measurements;
   G4double chamberLength = 121.92*cm; // length of tank
   G4double chamberThickness = 1.27*cm; // thickness of tank walls
@@ -300,6 +357,7 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
   G4double reflectorThickness = 0.254*cm; // reflector thickness approx
   G4double reflectorHeight = 14.478*cm; // reflector should run completely along inside of tank
   G4double reflectorWidth = 14.732*cm; // reflector should match width of inside of tank
+  fSegmentWidth = reflectorWidth;
 
   G4double scintLength = 121.92*cm; // scintillator size defined to fully fit one optical segment
   G4double scintWidth = 14.478*cm;
@@ -392,7 +450,15 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
   G4Box* outerCell
     = new G4Box("outerCell",
                 (chamberWidth*0.5 + chamberThickness), (chamberHeight*0.5 + chamberThickness), (chamberLength*0.5 + fWindowThickness));
-  G4SubtractionSolid* TankS = new G4SubtractionSolid("Tank", outerCell, innerCell); // Hollow acrylic box for tank
+
+  // Outer face of the end windows, where the PMT mounts and light guides start
+  fMountPlaneZ = chamberLength*0.5 + fWindowThickness;
+  // Hollow acrylic box for tank, or with primitive solids a full acrylic box
+  // with the oil inside placed in it as a box of its own
+  G4VSolid* TankS = outerCell;
+  if (!fPrimitiveSolids) {
+    TankS = new G4SubtractionSolid("Tank", outerCell, innerCell);
+  }
 
   G4LogicalVolume* TankLV
     = new G4LogicalVolume(TankS, acrylic, "Tank");
@@ -405,6 +471,13 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
                     0,               // copy number
                     fCheckOverlaps); // checking overlaps
 
+  // Mother volume of the reflectors and scintillators
+  G4LogicalVolume* chamberLV = detectLV;
+  if (fPrimitiveSolids) {
+    chamberLV = new G4LogicalVolume(innerCell, minOil, "TankInterior");
+    new G4PVPlacement(0, G4ThreeVector(), chamberLV, "TankInterior", TankLV, false, 0, fCheckOverlaps);
+  }
+
   G4cout << "Tank is " << chamberLength/cm << " cm of "
          << acrylic->GetName() << G4endl;
 
@@ -413,49 +486,23 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
   G4ThreeVector* positionReflector = nullptr;
   positionReflector = new G4ThreeVector[fNbOfReflectors];
 
-  G4double rowHalf = floor(rowCenter);
-  G4double colHalf = floor(colCenter);
-
-  G4cout << "Col Half is: " << colHalf << G4endl;
-  G4cout << "Row Half is: " << rowHalf << G4endl;
+  // Flat reflectors first, one row of fColNum per horizontal line from the
+  // bottom up, then upright ones, one column of fRowNum per vertical line
+  // from the left. Segment centres sit at (c - (fColNum-1)/2)*width and
+  // (r - (fRowNum-1)/2)*width, which also holds for even array sizes.
   G4int i = 0;
 
-  while(i < fNbOfReflectors){
-    if(i < (fColNum*(fRowNum + 1))) {
-      for(G4int county = (-1*(rowHalf+1)); county <= (rowHalf+1); county++){
-        for(G4int countx = (-1*colHalf); countx <= colHalf; countx++){
-          if(county == 0){
-            continue;
-          }
-          else{
-            if(county < 0){
-              positionReflector[i] = G4ThreeVector( (countx * reflectorWidth), (county * reflectorWidth + reflectorWidth*0.5), 0);
-            }
-            else{
-              positionReflector[i] = G4ThreeVector( (countx * reflectorWidth), (county * reflectorWidth - reflectorWidth*0.5), 0);
-            }
-          }
-          i++;
-        }
-      }
+  for(G4int line = 0; line <= fRowNum; line++){
+    for(G4int col = 0; col < fColNum; col++){
+      positionReflector[i] = G4ThreeVector( (col - (colCenter - 0.5)) * reflectorWidth, (line - rowCenter) * reflectorWidth, 0);
+      i++;
     }
-    else{
-      for(G4int countx = (-1*(colHalf+1)); countx <= (colHalf+1); countx++){
-        for(G4int county = (-1*rowHalf); county <= rowHalf; county++){
-          if(countx == 0){
-            continue;
-          }
-          else{
-            if(countx < 0){
-              positionReflector[i] = G4ThreeVector( (countx * reflectorWidth + reflectorWidth*0.5), (county * reflectorWidth), 0);
-            }
-            else{
-              positionReflector[i] = G4ThreeVector( (countx * reflectorWidth - reflectorWidth*0.5), (county * reflectorWidth), 0);
-            }
-          }
-          i++;
-        }
-      }
+  }
+
+  for(G4int line = 0; line <= fColNum; line++){
+    for(G4int row = 0; row < fRowNum; row++){
+      positionReflector[i] = G4ThreeVector( (line - colCenter) * reflectorWidth, (row - (rowCenter - 0.5)) * reflectorWidth, 0);
+      i++;
     }
   }
 
@@ -474,27 +521,29 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
   fLogicReflector[1]
     = new G4LogicalVolume(uprightReflector, refMat, "upReflect");
 
-  for (i = 0; i < fNbOfReflectors; i++){
-    if(i < (fColNum*(fRowNum + 1))){
-      new G4PVPlacement(0,
-                        positionReflector[i],
-                        fLogicReflector[0],
-                        "Reflector",
-                        detectLV,
-                        false,
-                        i,
-                        fCheckOverlaps);
-                      }
-    else{
-      new G4PVPlacement(0,
-                        positionReflector[i],
-                        fLogicReflector[1],
-                        "Reflector",
-                        detectLV,
-                        false,
-                        i,
-                        fCheckOverlaps);
-                      }
+  if (!fReplicate) {
+    for (i = 0; i < fNbOfReflectors; i++){
+      if(i < (fColNum*(fRowNum + 1))){
+        new G4PVPlacement(0,
+                          positionReflector[i],
+                          fLogicReflector[0],
+                          "Reflector",
+                          chamberLV,
+                          false,
+                          i,
+                          fCheckOverlaps);
+                        }
+      else{
+        new G4PVPlacement(0,
+                          positionReflector[i],
+                          fLogicReflector[1],
+                          "Reflector",
+                          chamberLV,
+                          false,
+                          i,
+                          fCheckOverlaps);
+                        }
+    }
   }
 
   // Scintillator
@@ -516,16 +565,26 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
     positionScint[i] = positionReflector[i] + G4ThreeVector(0, (0.5*reflectorWidth), 0);
   }
 
-  for(i = 0; i < fNbOfScints; i++){
-    new G4PVPlacement(0,
-                      positionScint[i],
-                      scintLV,
-                      "Scintillator",
-                      detectLV,
-                      false,
-                      i,
-                      fCheckOverlaps);
+  if (!fReplicate) {
+    for(i = 0; i < fNbOfScints; i++){
+      new G4PVPlacement(0,
+                        positionScint[i],
+                        scintLV,
+                        "Scintillator",
+                        chamberLV,
+                        false,
+                        i,
+                        fCheckOverlaps);
+    }
+  }
+
+  // Envelope of the fast optical transport model
+
+  G4Region* scintRegion = G4RegionStore::GetInstance()->GetRegion("ScintRegion", false);
+  if (!scintRegion) {
+    scintRegion = new G4Region("ScintRegion");
   }
+  scintRegion->AddRootLogicalVolume(scintLV);
 
   // Corner Tabs
 
@@ -622,39 +681,44 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
 
   // PMTs
 
-  // PMT Housing
-  G4Box* innerMount
-    = new G4Box("innerMount",
-                pmtMountWidth*0.5, pmtMountWidth*0.5, pmtMountLength*0.5);
-  G4Box* outerMount
-    = new G4Box("outerMount",
-                pmtOuterMountWidth*0.5, pmtOuterMountWidth*0.5, pmtMountLength*0.5);
-
-  G4SubtractionSolid* pmtMount = new G4SubtractionSolid("PmtMount", outerMount, innerMount);
-
-  G4LogicalVolume* pmtHousing = new G4LogicalVolume(pmtMount, nylon, "PMThousing");
-
-  // PMT Bulb
-
-  G4Sphere* pmtSphere
-    = new G4Sphere("PMTSphere", pmtInner, pmtRadius, 0.0*deg, 180.0*deg, 0.0*deg, 180.0*deg);
-
-  G4Box* deletionBox = new G4Box("deletionBox", 10*cm, pmtDistance, 10*cm);
-
-  G4SubtractionSolid* pmtSurface = new G4SubtractionSolid("PMTSurface", pmtSphere, deletionBox, 0, G4ThreeVector(0, 0, 0*cm));
+  // PMT Housing, a square tube. With primitive solids it is a four-sided
+  // polyhedron, radii to the sides, instead of a box with a box cut out.
+  G4VSolid* pmtMount = nullptr;
+  if (fPrimitiveSolids) {
+    G4double mountZ[2] = { -pmtMountLength*0.5, pmtMountLength*0.5 };
+    G4double mountInner[2] = { pmtMountWidth*0.5, pmtMountWidth*0.5 };
+    G4double mountOuter[2] = { pmtOuterMountWidth*0.5, pmtOuterMountWidth*0.5 };
+    pmtMount
+      = new G4Polyhedra("PmtMount", 45.*deg, 360.*deg, 4, 2, mountZ, mountInner, mountOuter);
+  }
+  else {
+    G4Box* innerMount
+      = new G4Box("innerMount",
+                  pmtMountWidth*0.5, pmtMountWidth*0.5, pmtMountLength*0.5);
+    G4Box* outerMount
+      = new G4Box("outerMount",
+                  pmtOuterMountWidth*0.5, pmtOuterMountWidth*0.5, pmtMountLength*0.5);
+
+    pmtMount = new G4SubtractionSolid("PmtMount", outerMount, innerMount);
+  }
 
-  G4LogicalVolume* pmtBulb = new G4LogicalVolume(pmtSurface, glass, "PMTBulb");
+  G4LogicalVolume* pmtHousing
+    = new G4LogicalVolume(pmtMount, nylon, "PMThousing");
 
-  // Light Guides
-  G4Cons* tryCone = new G4Cons("Cone", 0*cm, 1.414*pmtMountWidth*0.5, 0*cm, 5.6*cm, 1.5*cm, 0*deg, 360*deg);
+  // PMT Bulb and Light Guides, only in the selected version; the other one
+  // is built by TestSolids() when it is asked for. The solids of the last
+  // build went with the solid store.
+  fBulbInner = pmtInner;
+  fBulbRadius = pmtRadius;
+  fBulbCut = pmtDistance;
+  fGuideWidth = pmtMountWidth;
 
-  G4Box* tryBox = new G4Box("Box", pmtMountWidth*0.5 - 0.001*cm, pmtMountWidth*0.5 - 0.001*cm, 10*cm);
+  fBulbSolid[0] = fBulbSolid[1] = NULL;
+  fGuideSolid[0] = fGuideSolid[1] = NULL;
 
-  G4IntersectionSolid* tryGuide = new G4IntersectionSolid("Guide", tryCone, tryBox, 0, G4ThreeVector(0, 0, 8.5*cm));
+  G4LogicalVolume* pmtBulb = new G4LogicalVolume(BuildBulbSolid(fPrimitiveSolids), glass, "PMTBulb");
 
-  G4Box* tryBox2 = new G4Box("Box2", pmtMountWidth*0.5, pmtMountWidth*0.5, 1.5*cm);
-  G4SubtractionSolid* guideCone = new G4SubtractionSolid("Sigh", tryBox2, tryGuide, 0, G4ThreeVector(0, 0, 0*cm));
-  G4LogicalVolume* lightG = new G4LogicalVolume(guideCone, refMat, "Sigh");
+  G4LogicalVolume* lightG = new G4LogicalVolume(BuildGuideSolid(fPrimitiveSolids), refMat, "Sigh");
 
   G4ThreeVector* positionHousing = nullptr;
   positionHousing = new G4ThreeVector[fNbOfPMTs];
@@ -695,72 +759,161 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
 
   G4RotationMatrix* rotationPMT1 = new G4RotationMatrix();
   G4RotationMatrix* rotationPMT2 = new G4RotationMatrix();
-  rotationPMT1->rotateX(270.*deg);
-  rotationPMT2->rotateX(90.*deg);
+  if (!fPrimitiveSolids) {
+    rotationPMT1->rotateX(270.*deg);
+    rotationPMT2->rotateX(90.*deg);
+  }
+  else {
+    // The primitive bulb already faces +z
+    rotationPMT2->rotateX(180.*deg);
+  }
 
-  for(G4int copyNo = 0; copyNo < fNbOfPMTs; copyNo++){
+  if (!fReplicate) {
+    for(G4int copyNo = 0; copyNo < fNbOfPMTs; copyNo++){
+
+      if(copyNo < fNbOfPMTs/2){
+        new G4PVPlacement(0,
+                          positionHousing[copyNo],
+                          pmtHousing,
+                          "pmtHouse",
+                          detectLV,
+                          false,
+                          copyNo,
+                          fCheckOverlaps);
+
+        new G4PVPlacement(rotationPMT1,
+                          positionPMT[copyNo],
+                          pmtBulb,
+                          "pmtCathode",
+                          detectLV,
+                          false,
+                          copyNo,
+                          fCheckOverlaps);
+
+        new G4PVPlacement(rotationLightG1,
+                          positionLightG[copyNo],
+                          lightG,
+                          "lightG",
+                          detectLV,
+                          false,
+                          0,
+                          fCheckOverlaps
+                        );
+      }
+      else{
+        new G4PVPlacement(rotationPMT,
+                          positionHousing[copyNo],
+                          pmtHousing,
+                          "pmtHouse",
+                          detectLV,
+                          false,
+                          copyNo,
+                          fCheckOverlaps);
+
+        new G4PVPlacement(rotationPMT2,
+                          positionPMT[copyNo],
+                          pmtBulb,
+                          "pmtCathode",
+                          detectLV,
+                          false,
+                          copyNo,
+                          fCheckOverlaps);
+
+        new G4PVPlacement(rotationLightG2,
+                          positionLightG[copyNo],
+                          lightG,
+                          "lightG",
+                          detectLV,
+                          false,
+                          0,
+                          fCheckOverlaps
+                        );
+      }
+    }
+  }
 
-    if(copyNo < fNbOfPMTs/2){
-      new G4PVPlacement(0,
-                        positionHousing[copyNo],
-                        pmtHousing,
-                        "pmtHouse",
-                        detectLV,
-                        false,
-                        copyNo,
-                        fCheckOverlaps);
+  // Replicated array (/PII/det/replicate): the same volumes at the same
+  // positions, but placed once per cell instead of once per segment.
+  //
+  // In the tank, a layer of height reflectorWidth holds one row of segments
+  // and the flat reflectors above it, and is replicated along y. Each
+  // segment cell holds a scintillator and the upright reflector to its
+  // right, and is replicated along x. The bottom flat reflectors and the
+  // leftmost upright reflector of a layer are placed on their own.
+  // Each PMT plane is built the same way from cells holding a housing, a
+  // bulb and a light guide; the sensitive detector numbers the PMTs from
+  // the plane, row and column copy numbers.
+
+  if (fReplicate) {
+    G4double arrayWidth = dColNum*reflectorWidth + reflectorThickness;
+    G4double arrayHeight = dRowNum*reflectorWidth + reflectorThickness;
+
+    G4Box* arrayS = new G4Box("SegmentArray", arrayWidth*0.5, arrayHeight*0.5, reflectorLength*0.5);
+    G4LogicalVolume* arrayLV = new G4LogicalVolume(arrayS, minOil, "SegmentArray");
+    new G4PVPlacement(0, G4ThreeVector(), arrayLV, "SegmentArray", chamberLV, false, 0, fCheckOverlaps);
+
+    G4Box* layersS = new G4Box("SegmentLayers", arrayWidth*0.5, dRowNum*reflectorWidth*0.5, reflectorLength*0.5);
+    G4LogicalVolume* layersLV = new G4LogicalVolume(layersS, minOil, "SegmentLayers");
+    new G4PVPlacement(0, G4ThreeVector(0, reflectorThickness*0.5, 0), layersLV, "SegmentLayers", arrayLV, false, 0, fCheckOverlaps);
+
+    for (G4int col = 0; col < fColNum; col++) {
+      new G4PVPlacement(0, positionReflector[col], fLogicReflector[0], "Reflector", arrayLV, false, col, fCheckOverlaps);
+    }
 
-      new G4PVPlacement(rotationPMT1,
-                        positionPMT[copyNo],
-                        pmtBulb,
-                        "pmtCathode",
-                        detectLV,
-                        false,
-                        copyNo,
-                        fCheckOverlaps);
+    G4Box* layerS = new G4Box("SegmentLayer", arrayWidth*0.5, reflectorWidth*0.5, reflectorLength*0.5);
+    G4LogicalVolume* layerLV = new G4LogicalVolume(layerS, minOil, "SegmentLayer");
+    new G4PVReplica("SegmentLayer", layerLV, layersLV, kYAxis, fRowNum, reflectorWidth);
 
-      new G4PVPlacement(rotationLightG1,
-                        positionLightG[copyNo],
-                        lightG,
-                        "lightG",
-                        detectLV,
-                        false,
-                        0,
-                        fCheckOverlaps
-                      );
+    // Layer frame: the segments sit reflectorThickness/2 below its centre
+    G4double layerRowY = -reflectorThickness*0.5;
+
+    G4Box* rowS = new G4Box("SegmentRow", dColNum*reflectorWidth*0.5, reflectorHeight*0.5, reflectorLength*0.5);
+    G4LogicalVolume* rowLV = new G4LogicalVolume(rowS, minOil, "SegmentRow");
+    new G4PVPlacement(0, G4ThreeVector(reflectorThickness*0.5, layerRowY, 0), rowLV, "SegmentRow", layerLV, false, 0, fCheckOverlaps);
+
+    new G4PVPlacement(0, G4ThreeVector(-colCenter*reflectorWidth, layerRowY, 0), fLogicReflector[1], "Reflector", layerLV, false, 0, fCheckOverlaps);
+
+    for (G4int col = 0; col < fColNum; col++) {
+      G4ThreeVector position(positionReflector[col].x(), (reflectorWidth - reflectorThickness)*0.5, 0);
+      new G4PVPlacement(0, position, fLogicReflector[0], "Reflector", layerLV, false, col, fCheckOverlaps);
     }
-    else{
-      new G4PVPlacement(rotationPMT,
-                        positionHousing[copyNo],
-                        pmtHousing,
-                        "pmtHouse",
-                        detectLV,
-                        false,
-                        copyNo,
-                        fCheckOverlaps);
 
-      new G4PVPlacement(rotationPMT2,
-                        positionPMT[copyNo],
-                        pmtBulb,
-                        "pmtCathode",
-                        detectLV,
-                        false,
-                        copyNo,
-                        fCheckOverlaps);
+    G4Box* segmentS = new G4Box("Segment", reflectorWidth*0.5, reflectorHeight*0.5, reflectorLength*0.5);
+    G4LogicalVolume* segmentLV = new G4LogicalVolume(segmentS, minOil, "Segment");
+    new G4PVReplica("Segment", segmentLV, rowLV, kXAxis, fColNum, reflectorWidth);
 
-      new G4PVPlacement(rotationLightG2,
-                        positionLightG[copyNo],
-                        lightG,
-                        "lightG",
-                        detectLV,
-                        false,
-                        0,
-                        fCheckOverlaps
-                      );
+    new G4PVPlacement(0, G4ThreeVector(-reflectorThickness*0.5, 0, 0), scintLV, "Scintillator", segmentLV, false, 0, fCheckOverlaps);
+    new G4PVPlacement(0, G4ThreeVector((reflectorWidth - reflectorThickness)*0.5, 0, 0), fLogicReflector[1], "Reflector", segmentLV, false, 0, fCheckOverlaps);
+
+    // PMT planes, copy number 0 on the -z side and 1 on the +z side
+    G4Box* pmtPlaneS = new G4Box("PMTPlane", dColNum*reflectorWidth*0.5, dRowNum*reflectorWidth*0.5, pmtMountLength*0.5);
+    G4Box* pmtRowS = new G4Box("PMTRow", dColNum*reflectorWidth*0.5, reflectorWidth*0.5, pmtMountLength*0.5);
+    G4Box* pmtCellS = new G4Box("PMTCell", pmtOuterMountWidth*0.5, pmtOuterMountWidth*0.5, pmtMountLength*0.5);
+
+    G4double pmtOffset = pmtMountLength*0.5 - pmtSpacing - pmtWindow - pmtDistance;
+    G4double lightGOffset = pmtMountLength*0.5 - 1.55*cm;
+
+    for (G4int side = 0; side < 2; side++) {
+      G4double sign = side ? -1. : 1.;
+
+      G4LogicalVolume* pmtPlaneLV = new G4LogicalVolume(pmtPlaneS, minOil, "PMTPlane");
+      G4LogicalVolume* pmtRowLV = new G4LogicalVolume(pmtRowS, minOil, "PMTRow");
+      G4LogicalVolume* pmtCellLV = new G4LogicalVolume(pmtCellS, minOil, "PMTCell");
+
+      G4ThreeVector planePosition(0, 0, -sign*(chamberLength*0.5 + fWindowThickness + pmtMountLength*0.5));
+      new G4PVPlacement(0, planePosition, pmtPlaneLV, "PMTPlane", detectLV, false, side, fCheckOverlaps);
+      new G4PVReplica("PMTRow", pmtRowLV, pmtPlaneLV, kYAxis, fRowNum, reflectorWidth);
+      new G4PVReplica("PMTCell", pmtCellLV, pmtRowLV, kXAxis, fColNum, pmtOuterMountWidth);
+
+      new G4PVPlacement(side ? rotationPMT : 0, G4ThreeVector(),
+                        pmtHousing, "pmtHouse", pmtCellLV, false, 0, fCheckOverlaps);
+      new G4PVPlacement(side ? rotationPMT2 : rotationPMT1, G4ThreeVector(0, 0, sign*pmtOffset),
+                        pmtBulb, "pmtCathode", pmtCellLV, false, 0, fCheckOverlaps);
+      new G4PVPlacement(side ? rotationLightG2 : rotationLightG1, G4ThreeVector(0, 0, sign*lightGOffset),
+                        lightG, "lightG", pmtCellLV, false, 0, fCheckOverlaps);
     }
   }
 
-
   // Optical Surfaces (Skin surfaces surround the volume in all directions)
 
   new G4LogicalSkinSurface("reflectorSkin", fLogicReflector[0] , surfOpt);
@@ -768,6 +921,17 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
   new G4LogicalSkinSurface("lightGuideSkin", lightG, surfLightG);
   new G4LogicalSkinSurface("tabMatSkin", tabLV, tabMatSurf);
 
+  // Volume roles used to classify optical steps
+
+  SetVolumeRole(pmtBulb, kCathodeVolume);
+  SetVolumeRole(pmtHousing, kHousingVolume);
+  SetVolumeRole(fLogicReflector[0], kReflectorVolume);
+  SetVolumeRole(fLogicReflector[1], kReflectorVolume);
+  SetVolumeRole(scintLV, kScintillatorVolume);
+  SetVolumeRole(lightG, kLightGuideVolume);
+  SetVolumeRole(tabLV, kTabVolume);
+  SetVolumeRole(TankLV, kTankVolume);
+
   // Visualization attributes, can be tweaked as preferred
 
   G4VisAttributes* boxVisAtt1 = new G4VisAttributes(G4Colour(1.0, 1.0, 0.84, 1.0));
@@ -797,7 +961,12 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
   // Sets a max step length in the tracker region, with G4StepLimiter
 
   G4double maxStep = 0.25*chamberWidth;
-  fStepLimit = new G4UserLimits(maxStep);
+  if (!fStepLimit) {
+    fStepLimit = new G4UserLimits(maxStep);
+  }
+  else {
+    fStepLimit->SetMaxAllowedStep(maxStep);
+  }
   pmtHousing->SetUserLimits(fStepLimit);
 
   /// Set additional contraints on the track, with G4UserSpecialCuts
@@ -813,9 +982,302 @@ G4VPhysicalVolume* PIIDetectorConstruction::DefineVolumes()
   return worldPV;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIDetectorConstruction::SetVolumeRole(const G4LogicalVolume* volume,
+                                            PIIVolumeRole role)
+{
+  size_t id = volume->GetInstanceID();
+  if (id >= fVolumeRoles.size()) fVolumeRoles.resize(id + 1, kOtherVolume);
+  fVolumeRoles[id] = role;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* PIIDetectorConstruction::BuildBulbSolid(G4bool primitive)
+{
+  if (fBulbSolid[primitive]) return fBulbSolid[primitive];
+
+  if (!primitive) {
+    G4Sphere* pmtSphere
+      = new G4Sphere("PMTSphere", fBulbInner, fBulbRadius, 0.0*deg, 180.0*deg, 0.0*deg, 180.0*deg);
+
+    G4Box* deletionBox = new G4Box("deletionBox", 10*cm, fBulbCut, 10*cm);
+
+    fBulbSolid[0] = new G4SubtractionSolid("PMTSurface", pmtSphere, deletionBox, 0, G4ThreeVector(0, 0, 0*cm));
+  }
+  else {
+    // Primitive bulb: the spherical shell cut at the polar angle where its
+    // outer surface meets the cut plane, with the cap along +z instead of +y.
+    // The outer surface is the same; the rim is a cone instead of a plane.
+    fBulbSolid[1]
+      = new G4Sphere("PMTSurface", fBulbInner, fBulbRadius, 0.0*deg, 360.0*deg,
+                     0.0*deg, std::acos(fBulbCut/fBulbRadius));
+  }
+
+  return fBulbSolid[primitive];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* PIIDetectorConstruction::BuildGuideSolid(G4bool primitive)
+{
+  if (fGuideSolid[primitive]) return fGuideSolid[primitive];
+
+  if (!primitive) {
+    G4Cons* tryCone = new G4Cons("Cone", 0*cm, 1.414*fGuideWidth*0.5, 0*cm, 5.6*cm, 1.5*cm, 0*deg, 360*deg);
+
+    G4Box* tryBox = new G4Box("Box", fGuideWidth*0.5 - 0.001*cm, fGuideWidth*0.5 - 0.001*cm, 10*cm);
+
+    G4IntersectionSolid* tryGuide = new G4IntersectionSolid("Guide", tryCone, tryBox, 0, G4ThreeVector(0, 0, 8.5*cm));
+
+    G4Box* tryBox2 = new G4Box("Box2", fGuideWidth*0.5, fGuideWidth*0.5, 1.5*cm);
+    fGuideSolid[0] = new G4SubtractionSolid("Sigh", tryBox2, tryGuide, 0, G4ThreeVector(0, 0, 0*cm));
+  }
+  else {
+    fGuideSolid[1] = BuildTessellatedGuide(fGuideWidth*0.5, fGuideWidth*0.5 - 0.001*cm,
+                                           1.414*fGuideWidth*0.5, 5.6*cm, 1.5*cm);
+  }
+
+  return fGuideSolid[primitive];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* PIIDetectorConstruction::BuildTessellatedGuide(G4double halfWidth,
+                                                         G4double holeHalfWidth,
+                                                         G4double rBottom,
+                                                         G4double rTop,
+                                                         G4double halfLength)
+{
+  // Square plate with a conical hole clipped to a square, as in the boolean
+  // guide. Every vertex lies on the boolean surface: kNbOfSides columns in
+  // azimuth, starting at a corner, and kNbOfLevels steps along z per column.
+  // Where the square clips the cone, one step ends on the clipping line, so
+  // the column follows the square and then the cone.
+  const G4int kNbOfSides = 128;
+  const G4int kNbOfLevels = 6;
+
+  std::vector<std::vector<G4ThreeVector> > hole(kNbOfSides);
+  std::vector<G4ThreeVector> outer(kNbOfSides);
+
+  for (G4int k = 0; k < kNbOfSides; k++) {
+    G4double phi = 45.*deg + k*360.*deg/kNbOfSides;
+    G4ThreeVector u(std::cos(phi), std::sin(phi), 0.);
+    G4double toSide = 1./std::max(std::abs(u.x()), std::abs(u.y()));
+    G4double clip = holeHalfWidth*toSide;
+
+    outer[k] = halfWidth*toSide*u;
+
+    std::vector<G4double> z(kNbOfLevels + 1);
+    G4double zClip = -halfLength;
+    G4int kink = 0;
+    if (rBottom > clip && rTop < clip) {
+      zClip = -halfLength + 2.*halfLength*(rBottom - clip)/(rBottom - rTop);
+      kink = std::min(kNbOfLevels - 1,
+                      G4int(kNbOfLevels*(zClip + halfLength)/(2.*halfLength) + 0.5));
+    }
+
+    // Clipping lines closer to the bottom than half a step stay between levels
+    if (kink > 0) {
+      for (G4int j = 0; j <= kink; j++)
+        z[j] = -halfLength + (zClip + halfLength)*j/kink;
+      for (G4int j = kink; j <= kNbOfLevels; j++)
+        z[j] = zClip + (halfLength - zClip)*(j - kink)/(kNbOfLevels - kink);
+    }
+    else {
+      for (G4int j = 0; j <= kNbOfLevels; j++)
+        z[j] = -halfLength + 2.*halfLength*j/kNbOfLevels;
+    }
+
+    for (G4int j = 0; j <= kNbOfLevels; j++) {
+      G4double cone = rBottom + (rTop - rBottom)*(z[j] + halfLength)/(2.*halfLength);
+      hole[k].push_back(std::min(cone, clip)*u + G4ThreeVector(0, 0, z[j]));
+    }
+  }
+
+  // Facets are counter-clockwise seen from outside the material
+  G4TessellatedSolid* guide = new G4TessellatedSolid("Sigh");
+  G4ThreeVector top(0, 0, halfLength);
+
+  for (G4int k = 0; k < kNbOfSides; k++) {
+    G4int n = (k + 1) % kNbOfSides;
+    const std::vector<G4ThreeVector>& a = hole[k];
+    const std::vector<G4ThreeVector>& b = hole[n];
+
+    // Outer side
+    guide->AddFacet(new G4TriangularFacet(outer[k] - top, outer[n] - top, outer[n] + top, ABSOLUTE));
+    guide->AddFacet(new G4TriangularFacet(outer[k] - top, outer[n] + top, outer[k] + top, ABSOLUTE));
+
+    // Hole
+    for (G4int j = 0; j < kNbOfLevels; j++) {
+      guide->AddFacet(new G4TriangularFacet(a[j], a[j+1], b[j+1], ABSOLUTE));
+      guide->AddFacet(new G4TriangularFacet(a[j], b[j+1], b[j], ABSOLUTE));
+    }
+
+    // Top and bottom faces
+    guide->AddFacet(new G4TriangularFacet(a[kNbOfLevels], outer[k] + top, outer[n] + top, ABSOLUTE));
+    guide->AddFacet(new G4TriangularFacet(a[kNbOfLevels], outer[n] + top, b[kNbOfLevels], ABSOLUTE));
+    guide->AddFacet(new G4TriangularFacet(a[0], b[0], outer[n] - top, ABSOLUTE));
+    guide->AddFacet(new G4TriangularFacet(a[0], outer[n] - top, outer[k] - top, ABSOLUTE));
+  }
+
+  guide->SetSolidClosed(true);
+  return guide;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PIIDetectorConstruction::GetSegment(const G4ThreeVector& position) const
+{
+  // Segment centres sit at (c - (fColNum-1)/2)*width and
+  // (r - (fRowNum-1)/2)*width, numbered like the left PMTs, r*fColNum + c.
+  // Positions outside the array are clamped to the nearest segment.
+  if (fSegmentWidth <= 0.) return 0;
+
+  G4int col = (G4int)std::floor(position.x()/fSegmentWidth + 0.5*fColNum);
+  G4int row = (G4int)std::floor(position.y()/fSegmentWidth + 0.5*fRowNum);
+  col = std::min(std::max(col, 0), fColNum - 1);
+  row = std::min(std::max(row, 0), fRowNum - 1);
+
+  return row*fColNum + col;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector PIIDetectorConstruction::GetSegmentCentre(G4int segment) const
+{
+  G4int row = segment / fColNum;
+  G4int col = segment % fColNum;
+
+  return G4ThreeVector((col - 0.5*(fColNum - 1))*fSegmentWidth,
+                       (row - 0.5*(fRowNum - 1))*fSegmentWidth, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIDetectorConstruction::TestSolids(G4int nbOfRays)
+{
+  if (!fBulbSolid[fPrimitiveSolids]) {
+    G4cout << "/PII/det/testSolids: the geometry is not built yet" << G4endl;
+    return;
+  }
+
+  // Only the selected version is built with the geometry, add the other
+  BuildBulbSolid(!fPrimitiveSolids);
+  BuildGuideSolid(!fPrimitiveSolids);
+
+  // The primitive bulb has its cap along +z, the boolean one along +y
+  G4RotationMatrix bulbFrame;
+  bulbFrame.rotateX(90.*deg);
+
+  CompareSolids("PMT bulb", fBulbSolid[0], fBulbSolid[1], bulbFrame, nbOfRays);
+  CompareSolids("Light guide", fGuideSolid[0], fGuideSolid[1], G4RotationMatrix(), nbOfRays);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIDetectorConstruction::CompareSolids(const G4String& name,
+                                            const G4VSolid* boolean,
+                                            const G4VSolid* primitive,
+                                            const G4RotationMatrix& frame,
+                                            G4int nbOfRays) const
+{
+  // Random points in the bounding box of the boolean solid plus a margin,
+  // each with a random direction; frame takes them to the primitive solid
+  G4ThreeVector pMin, pMax;
+  boolean->BoundingLimits(pMin, pMax);
+  G4ThreeVector centre = 0.5*(pMin + pMax);
+  G4ThreeVector halfSize = 0.6*(pMax - pMin);
+
+  std::vector<G4ThreeVector> points, directions;
+  G4int insideMismatches = 0;
+
+  for (G4int i = 0; i < nbOfRays; i++) {
+    G4ThreeVector point = centre + G4ThreeVector((2.*G4UniformRand() - 1.)*halfSize.x(),
+                                                 (2.*G4UniformRand() - 1.)*halfSize.y(),
+                                                 (2.*G4UniformRand() - 1.)*halfSize.z());
+    EInside booleanInside = boolean->Inside(point);
+    EInside primitiveInside = primitive->Inside(frame*point);
+
+    if (booleanInside != kSurface && primitiveInside != kSurface
+        && booleanInside != primitiveInside) insideMismatches++;
+
+    // Rays start outside both solids, as photons arriving at a volume do
+    if (booleanInside == kOutside && primitiveInside == kOutside) {
+      points.push_back(point);
+      directions.push_back(G4RandomDirection());
+    }
+  }
+
+  size_t nbOfTraced = points.size();
+  std::vector<G4double> booleanDistance(nbOfTraced), primitiveDistance(nbOfTraced);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nbOfTraced; i++)
+    booleanDistance[i] = boolean->DistanceToIn(points[i], directions[i]);
+  auto middle = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nbOfTraced; i++)
+    primitiveDistance[i] = primitive->DistanceToIn(frame*points[i], frame*directions[i]);
+  auto end = std::chrono::steady_clock::now();
+
+  G4int hits = 0;
+  G4int hitMismatches = 0;
+  G4double sumDifference = 0.;
+  G4double maxDifference = 0.;
+
+  for (size_t i = 0; i < nbOfTraced; i++) {
+    G4bool booleanHit = (booleanDistance[i] != kInfinity);
+    G4bool primitiveHit = (primitiveDistance[i] != kInfinity);
+
+    if (booleanHit != primitiveHit) {
+      hitMismatches++;
+    }
+    else if (booleanHit) {
+      G4double difference = std::abs(booleanDistance[i] - primitiveDistance[i]);
+      sumDifference += difference;
+      maxDifference = std::max(maxDifference, difference);
+      hits++;
+    }
+  }
+
+  G4double perRay = nbOfTraced ? 1.e9/nbOfTraced : 0.;
+
+  G4cout << "--- " << name << ": " << nbOfRays << " points, "
+         << insideMismatches << " inside/outside mismatches" << G4endl
+         << "    " << nbOfTraced << " rays, " << hits << " hit both, "
+         << hitMismatches << " hit one only, distance difference mean "
+         << G4BestUnit(hits ? sumDifference/hits : 0., "Length")
+         << " max " << G4BestUnit(maxDifference, "Length") << G4endl
+         << "    DistanceToIn per ray: boolean "
+         << std::chrono::duration<G4double>(middle - start).count()*perRay << " ns, primitive "
+         << std::chrono::duration<G4double>(end - middle).count()*perRay << " ns" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void PIIDetectorConstruction::ConstructSDandField()
 {
+  // Fast optical transport in the scintillator, off until
+  // /PII/fastsim/scintillator is set. The model belongs to the region, which
+  // outlives geometry rebuilds, so each thread creates it once.
+  if (!fScintModel) {
+    G4Region* scintRegion = G4RegionStore::GetInstance()->GetRegion("ScintRegion");
+
+    fScintModel = new PIIScintFastModel("PIIScintFastModel", scintRegion, surfOpt);
+    G4AutoDelete::Register(fScintModel);
+  }
 
+  // Photon-counting sensitive detector on the PMT cathodes, reused for the
+  // bulbs of a rebuilt geometry
+  G4String pmtSDname = "PII/PMTSD";
+  G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+  G4VSensitiveDetector* pmtSD = sdManager->FindSensitiveDetector(pmtSDname, false);
+  if (!pmtSD) {
+    pmtSD = new PIITrackerSD(pmtSDname, "PMTHitsCollection");
+    sdManager->AddNewDetector(pmtSD);
+  }
+  SetSensitiveDetector("PMTBulb", pmtSD, true);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -832,6 +1294,24 @@ void PIIDetectorConstruction::SetCheckOverlaps(G4bool checkOverlaps)
   fCheckOverlaps = checkOverlaps;
 }
 
+void PIIDetectorConstruction::SetReplicate(G4bool replicate)
+{
+  fReplicate = replicate;
+  G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void PIIDetectorConstruction::SetPrimitiveSolids(G4bool primitive)
+{
+  fPrimitiveSolids = primitive;
+  G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void PIIDetectorConstruction::SetFastSimulation(G4bool fastSim)
+{
+  // The models are per thread, the switch is shared
+  PIIScintFastModel::SetEnabled(fastSim);
+}
+
 void PIIDetectorConstruction::SetRowNumb(G4int rowNumber)
 {
   fRowNum = rowNumber;
@@ -8,6 +8,7 @@
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
 #include "G4UIcommand.hh"
 #include "G4SystemOfUnits.hh"
 
@@ -65,6 +66,59 @@ PIIDetectorMessenger::PIIDetectorMessenger(PIIDetectorConstruction* Det)
   fDefaultsCmd->SetGuidance("Set all generator values to defaults.");
   fDefaultsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
   fDefaultsCmd->SetToBeBroadcasted(false);
+
+  fReplicateCmd = new G4UIcmdWithABool("/PII/det/replicate", this);
+  fReplicateCmd->SetGuidance("Build the segment and PMT arrays from replicated cells.");
+  fReplicateCmd->SetGuidance("Volumes and positions are the same as with one placement per volume,");
+  fReplicateCmd->SetGuidance("but construction and navigation do not grow with the array size.");
+  fReplicateCmd->SetGuidance("Default value is false.");
+  fReplicateCmd->SetParameterName("replicate", true);
+  fReplicateCmd->SetDefaultValue(true);
+  fReplicateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fReplicateCmd->SetToBeBroadcasted(false);
+
+  fCheckOverlapsCmd = new G4UIcmdWithABool("/PII/det/checkOverlaps", this);
+  fCheckOverlapsCmd->SetGuidance("Check every placement for overlaps when the geometry is built.");
+  fCheckOverlapsCmd->SetGuidance("Default value is true.");
+  fCheckOverlapsCmd->SetParameterName("checkOverlaps", true);
+  fCheckOverlapsCmd->SetDefaultValue(true);
+  fCheckOverlapsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCheckOverlapsCmd->SetToBeBroadcasted(false);
+
+  fPrimitiveSolidsCmd = new G4UIcmdWithABool("/PII/det/primitiveSolids", this);
+  fPrimitiveSolidsCmd->SetGuidance("Build the tank, PMT housings, bulbs and light guides without boolean solids.");
+  fPrimitiveSolidsCmd->SetGuidance("The bulb rim becomes a cone and the light guide a tessellated solid;");
+  fPrimitiveSolidsCmd->SetGuidance("use /PII/det/testSolids to compare them with the boolean ones.");
+  fPrimitiveSolidsCmd->SetGuidance("Default value is false.");
+  fPrimitiveSolidsCmd->SetParameterName("primitiveSolids", true);
+  fPrimitiveSolidsCmd->SetDefaultValue(true);
+  fPrimitiveSolidsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fPrimitiveSolidsCmd->SetToBeBroadcasted(false);
+
+  fTestSolidsCmd = new G4UIcmdWithAnInteger("/PII/det/testSolids", this);
+  fTestSolidsCmd->SetGuidance("Shoot random points and rays at the boolean and primitive bulb and light guide.");
+  fTestSolidsCmd->SetGuidance("Prints inside/outside and hit mismatches, distance differences");
+  fTestSolidsCmd->SetGuidance("and the time per DistanceToIn call of each solid.");
+  fTestSolidsCmd->SetParameterName("nbOfRays", true);
+  fTestSolidsCmd->SetDefaultValue(100000);
+  fTestSolidsCmd->SetRange("nbOfRays > 0");
+  fTestSolidsCmd->AvailableForStates(G4State_Idle);
+  fTestSolidsCmd->SetToBeBroadcasted(false);
+
+  fFastSimDirectory = new G4UIdirectory("/PII/fastsim/");
+  fFastSimDirectory->SetGuidance("Fast simulation control");
+
+  fFastSimCmd = new G4UIcmdWithABool("/PII/fastsim/scintillator", this);
+  fFastSimCmd->SetGuidance("Transport photons inside the scintillator analytically.");
+  fFastSimCmd->SetGuidance("Photons are handed back to full tracking 1 mm before the end faces");
+  fFastSimCmd->SetGuidance("and the corner tabs, which are fully tracked.");
+  fFastSimCmd->SetGuidance("Compare with a run without it to validate a geometry change,");
+  fFastSimCmd->SetGuidance("for instance with the fastsim_compare.txt sweep.");
+  fFastSimCmd->SetGuidance("Default value is false.");
+  fFastSimCmd->SetParameterName("scintillator", true);
+  fFastSimCmd->SetDefaultValue(true);
+  fFastSimCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fFastSimCmd->SetToBeBroadcasted(false);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -79,6 +133,12 @@ PIIDetectorMessenger::~PIIDetectorMessenger()
   delete fHousingThicknessCmd;
   delete fWindowThicknessCmd;
   delete fDefaultsCmd;
+  delete fReplicateCmd;
+  delete fCheckOverlapsCmd;
+  delete fPrimitiveSolidsCmd;
+  delete fTestSolidsCmd;
+  delete fFastSimCmd;
+  delete fFastSimDirectory;
 
 }
 
@@ -106,6 +166,26 @@ void PIIDetectorMessenger::SetNewValue(G4UIcommand* command,G4String newValue)
   if(command == fHousingThicknessCmd) {
     fDetectorConstruction->SetHousingThickness(fHousingThicknessCmd->GetNewDoubleValue(newValue));
   }
+
+  if(command == fReplicateCmd) {
+    fDetectorConstruction->SetReplicate(fReplicateCmd->GetNewBoolValue(newValue));
+  }
+
+  if(command == fCheckOverlapsCmd) {
+    fDetectorConstruction->SetCheckOverlaps(fCheckOverlapsCmd->GetNewBoolValue(newValue));
+  }
+
+  if(command == fPrimitiveSolidsCmd) {
+    fDetectorConstruction->SetPrimitiveSolids(fPrimitiveSolidsCmd->GetNewBoolValue(newValue));
+  }
+
+  if(command == fTestSolidsCmd) {
+    fDetectorConstruction->TestSolids(fTestSolidsCmd->GetNewIntValue(newValue));
+  }
+
+  if(command == fFastSimCmd) {
+    fDetectorConstruction->SetFastSimulation(fFastSimCmd->GetNewBoolValue(newValue));
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
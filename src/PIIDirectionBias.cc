@@ -0,0 +1,123 @@
+/// \file PIIDirectionBias.cc
+/// \brief Implementation of the PIIDirectionBias class
+
+#include "PIIDirectionBias.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIDirectionBias::PIIDirectionBias()
+ : fMode(kNone), fConeAngle(30.*deg), fConeFraction(0.5), fMeanImportance(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIDirectionBias::~PIIDirectionBias()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PIIDirectionBias::Sample(G4ThreeVector& dir) const
+{
+  G4double cosTheta = 1. - 2.*G4UniformRand();
+  G4double weight = 1.;
+
+  if (fMode == kCones) {
+    G4double cosCone = std::cos(fConeAngle);
+
+    if (G4UniformRand() < fConeFraction) {
+      G4double cosAxis = 1. - (1. - cosCone)*G4UniformRand();
+      cosTheta = (G4UniformRand() < 0.5) ? cosAxis : -cosAxis;
+    }
+
+    // Isotropic part plus every cone the direction falls in, both of them
+    // where the cones overlap, beyond 90 degrees
+    G4double coneDensity = fConeFraction/(1. - cosCone);
+    G4double density = 1. - fConeFraction;
+    if (cosTheta >= cosCone) density += coneDensity;
+    if (-cosTheta >= cosCone) density += coneDensity;
+    weight = 1./density;
+  }
+  else if (fMode == kMap && !fCumulative.empty()) {
+    size_t nBins = fCumulative.size();
+    size_t bin = std::lower_bound(fCumulative.begin(), fCumulative.end(),
+                                  G4UniformRand()) - fCumulative.begin();
+    if (bin >= nBins) bin = nBins - 1;
+
+    cosTheta = -1. + 2.*(bin + G4UniformRand())/nBins;
+    weight = fMeanImportance/fImportance[bin];
+  }
+
+  G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+  G4double phi = twopi*G4UniformRand();
+  dir = G4ThreeVector(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+
+  return weight;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIIDirectionBias::ReadMap(const G4String& fileName)
+{
+  fImportance.clear();
+  fCumulative.clear();
+  fMeanImportance = 0.;
+
+  std::ifstream in(fileName);
+  if (!in) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open direction map " << fileName;
+    G4Exception("PIIDirectionBias::ReadMap()", "PIIDirectionBias001", JustWarning, msg);
+    return false;
+  }
+
+  // One importance per line, for equal bins of cos(theta) from -1 to 1
+  std::vector<G4double> importance;
+  std::string line;
+
+  for (G4int lineNo = 1; std::getline(in, line); lineNo++) {
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line.erase(hash);
+
+    std::istringstream fields(line);
+    G4double value;
+    if (!(fields >> value)) continue;
+
+    // A bin that is never drawn would be missing from the weighted tallies
+    if (!(value > 0.)) {
+      G4ExceptionDescription msg;
+      msg << fileName << ", line " << lineNo << ": importance must be positive";
+      G4Exception("PIIDirectionBias::ReadMap()", "PIIDirectionBias002", JustWarning, msg);
+      return false;
+    }
+    importance.push_back(value);
+  }
+
+  if (importance.empty()) {
+    G4ExceptionDescription msg;
+    msg << "Direction map " << fileName << " has no bins";
+    G4Exception("PIIDirectionBias::ReadMap()", "PIIDirectionBias003", JustWarning, msg);
+    return false;
+  }
+
+  G4double sum = 0.;
+  for (size_t i = 0; i < importance.size(); i++) {
+    sum += importance[i];
+    fCumulative.push_back(sum);
+  }
+  for (size_t i = 0; i < fCumulative.size(); i++) fCumulative[i] /= sum;
+
+  fImportance = importance;
+  fMeanImportance = sum/importance.size();
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
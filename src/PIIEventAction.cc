@@ -3,10 +3,18 @@
 
 #include "PIIEventAction.hh"
 #include "PIIAnalysis.hh"
+#include "PIIBombAccumulable.hh"
 #include "PIIDetectorConstruction.hh"
+#include "PIILightMap.hh"
+#include "PIITrackerHit.hh"
+#include "PIIUniverseAccumulable.hh"
 
 #include "G4Event.hh"
 #include "G4EventManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4SDManager.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 #include "G4TrajectoryContainer.hh"
 #include "G4Trajectory.hh"
 #include "G4Run.hh"
@@ -19,153 +27,217 @@
 
 PIIEventAction::PIIEventAction(PIIDetectorConstruction* detectorConstruction)
 : G4UserEventAction(),
-  fDetConstruction(detectorConstruction)
+  fPhotonsPerEvent(1),
+  fBombSize(10000),
+  fEventOffset(0),
+  fPathSummary(false),
+  fPhotonNtuple(-1),
+  fSourcesH1(-1),
+  fHitsH2(-1),
+  fTimeSumH2(-1),
+  fTimesH2(-1),
+  fBiased(false),
+  fOutputWriter(nullptr),
+  fLightMap(nullptr),
+  fUniverses(nullptr),
+  fBombs(nullptr),
+  fDirectionBias(nullptr),
+  fDetConstruction(detectorConstruction),
+  fPMTHitsCollectionID(-1)
 {
-  G4int fNbOfPMTs = fDetConstruction->GetNoPMT();
-  PMTHits = new G4int[fNbOfPMTs];
-  PMTHits2 = new G4int[fNbOfPMTs];
+  // Resized by the run action once the geometry of the run is known
+  fRecord.Allocate(fDetConstruction->GetNoPMT(), fPhotonsPerEvent);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 PIIEventAction::~PIIEventAction()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIEventAction::BeginOfEventAction(const G4Event* event)
 {
-  delete PMTHits;
-  delete PMTHits2;
+  // One record per primary photon, taken from the vertices of the generator;
+  // photons split during the event are added by the stepping action
+  G4int nPhotons = event->GetNumberOfPrimaryVertex();
+  fRecord.Reset(nPhotons);
+
+  for(G4int k = 0; k < nPhotons; k++){
+    G4PrimaryVertex* vertex = event->GetPrimaryVertex(k);
+
+    fRecord.pos[k] = vertex->GetPosition();
+    fRecord.dir[k] = vertex->GetPrimary()->GetMomentumDirection();
+
+    // Importance weight of a biased direction, replaced by the track weight
+    // when the photon is tracked
+    fRecord.weight[k] = vertex->GetWeight() * vertex->GetPrimary()->GetWeight();
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void PIIEventAction::BeginOfEventAction(const G4Event*)
-{}
+void PIIEventAction::FillRow(G4VAnalysisManager* man, const PIIOutputRecord& row)
+{
+  // Hand the row to the writer thread when there is one running
+  if (fOutputWriter && fOutputWriter->IsRunning()) {
+    fOutputWriter->Push(row);
+  }
+  else {
+    PIIOutputWriter::Fill(man, row);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIEventAction::CollectPMTHits(const G4Event* event)
+{
+  G4HCofThisEvent* hce = event->GetHCofThisEvent();
+  if (!hce) return;
+
+  if (fPMTHitsCollectionID < 0) {
+    fPMTHitsCollectionID
+      = G4SDManager::GetSDMpointer()->GetCollectionID("PMTHitsCollection");
+  }
+
+  PIITrackerHitsCollection* hits
+    = static_cast<PIITrackerHitsCollection*>(hce->GetHC(fPMTHitsCollectionID));
+  if (!hits) return;
+
+  G4int nHits = hits->entries();
+  for (G4int i = 0; i < nHits; i++) {
+    const PIITrackerHit* hit = (*hits)[i];
+    SetPhotonHit(hit->GetTrackID(), hit->GetPMTNb(), hit->GetTime());
+  }
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void PIIEventAction::EndOfEventAction(const G4Event* event)
 {
+  CollectPMTHits(event);
 
-  G4int nbOfPMTs = fDetConstruction->GetNoPMT();
   G4int nbOfRows = fDetConstruction->GetNoRows();
   G4int nbOfCols = fDetConstruction->GetNoCols();
-  G4int copyNo = GetCurrentPMTHit();
-
-  if(photonFlag != 1){
-    copyNo = photonFlag;
-  }
 
   SetNoRows(nbOfRows);
   SetNoCols(nbOfCols);
 
-  G4int* hits = nullptr;
-  G4int* hits2 = nullptr;
-  hits = new G4int[nbOfPMTs];
-  hits2 = new G4int[nbOfPMTs];
+  eventID = event->GetEventID();
 
-  for(G4int c = 0; c < nbOfPMTs; c++){
-    hits[c] = GetPhotonHit(c);
-    hits2[c] = GetPhotonHit2(c);
-  }
-  // periodic printing
+  // Get analysis manager
+  G4VAnalysisManager* man = PIIAnalysis::Instance();
 
-  G4int nEvents = GetNoEvents();
-  G4ThreeVector pos = GetPos();
-  G4ThreeVector dir = GetDirection();
+  PIIOutputRecord row;
 
-  G4double x_pos = pos.x();
-  G4double y_pos = pos.y();
-  G4double z_pos = pos.z();
+  // Photons are numbered over the whole run so that rows and bombs do not
+  // depend on how many photons each event carries, nor on the shard the
+  // run belongs to (/PII/random/eventOffset)
+  G4int nPhotons = fRecord.nPhotons;
 
-  G4double x_dir = dir.x();
-  G4double y_dir = dir.y();
-  G4double z_dir = dir.z();
+  if(fUniverses) fUniverses->AddPhotons(nPhotons);
 
-  G4double time = GetEventTime();
+  for(G4int k = 0; k < nPhotons; k++){
 
-  eventID = event->GetEventID();
+    G4long photonNo = (fEventOffset + eventID) * fPhotonsPerEvent + k + 1;
 
-  // Get analysis manager
-  G4AnalysisManager* man = G4AnalysisManager::Instance();
+    // The photon, then the copies split from it, which share its number.
+    // Every tally adds the photon weight, 1 unless tracking is biased.
+    for(G4int r = k; r >= 0; r = fRecord.nextCopy[r]){
 
-  if (eventID == (nEvents - 1)) {
-    G4cout << ">>> Event: " << eventID + 1 << G4endl;
+      const G4ThreeVector& pos = fRecord.pos[r];
+      const G4ThreeVector& dir = fRecord.dir[r];
+      G4int flag = fRecord.flag[r];
+      G4int pmt = fRecord.pmt[r];
+      G4double time = fRecord.time[r];
+      G4double weight = fRecord.weight[r];
 
-    for(G4int counter = 0; counter < nbOfPMTs; counter ++){
-      G4cout << "    "
-             << hits2[counter] << " hits stored in PMT " << (counter + 1) << G4endl;
-    }
+      G4int copyNo = pmt;
 
-    G4cout << "Number of events: " << nEvents << G4endl;
+      if(flag == 1){
+        fRecord.runHits[pmt] += weight;
+        fRecord.runTimeSum[pmt] += weight*time;
+        fRecord.runTimeSum2[pmt] += weight*time*time;
+        fRecord.runDetected += weight;
 
-    man->FillNtupleIColumn(0, 0, nbOfPMTs);
-    man->FillNtupleIColumn(0, 1, nbOfRows);
-    man->FillNtupleIColumn(0, 2, nbOfCols);
-    man->AddNtupleRow(0);
-  }
+        if(fUniverses){
+          fUniverses->AddPhoton(pmt, fRecord.reflectorBounces[r], fRecord.guideBounces[r],
+                                fRecord.tabBounces[r], fRecord.scintDepth[r],
+                                fRecord.oilDepth[r], weight);
+        }
+      }
+      else{
+        copyNo = flag;
+        if(flag == -1) fRecord.runHousing += weight;
+        else fRecord.runLost += weight;
+      }
 
-  // Fill ntuple
-  if(outputFlag == 1){
-
-    man->FillNtupleIColumn(1, 0, eventID+1);
-    man->FillNtupleIColumn(1, 1, copyNo);
-    man->FillNtupleDColumn(1, 2, x_pos);
-    man->FillNtupleDColumn(1, 3, y_pos);
-    man->FillNtupleDColumn(1, 4, z_pos);
-    man->FillNtupleDColumn(1, 5, x_dir);
-    man->FillNtupleDColumn(1, 6, y_dir);
-    man->FillNtupleDColumn(1, 7, z_dir);
-    man->FillNtupleDColumn(1, 8, time);
-    man->AddNtupleRow(1);
-  }
+      // Fill ntuple
+      if(outputFlag == 1 || outputFlag == 3){
+
+        row.ntupleId = fPhotonNtuple;
+        row.nInts = 2;
+        row.ints[0] = (G4int)photonNo; // in range, checked at the start of the run
+        row.ints[1] = copyNo;
+        row.doubles[0] = pos.x();
+        row.doubles[1] = pos.y();
+        row.doubles[2] = pos.z();
+        row.doubles[3] = dir.x();
+        row.doubles[4] = dir.y();
+        row.doubles[5] = dir.z();
+        row.doubles[6] = time;
+
+        G4int nDoubles = 7;
+        if(fBiased){
+          row.doubles[nDoubles++] = weight;
+        }
+        if(fPathSummary){
+          row.doubles[nDoubles++] = fRecord.scintPath[r];
+          row.doubles[nDoubles++] = fRecord.reflectorBounces[r];
+          row.doubles[nDoubles++] = fRecord.guideBounces[r];
+          row.doubles[nDoubles++] = fRecord.tabBounces[r];
+        }
+        row.nDoubles = nDoubles;
+        FillRow(man, row);
+      }
 
-  else if(outputFlag == 2){
+      // Light map generation, copies only add hits
+      if(fLightMap){
+        fLightMap->Fill(pos, (flag == 1) ? pmt : -1, time, weight, r == k);
+      }
 
-    if ((eventID + 1) % 10000 == 0){
-      G4cout << "Printing to file." << G4endl;
-      man->FillNtupleIColumn(1, 0, eventID+1);
-      man->FillNtupleIColumn(1, 1, hits[4]);
-      man->FillNtupleIColumn(1, 2, hits[13]);
-      man->FillNtupleDColumn(1, 3, x_pos);
-      man->FillNtupleDColumn(1, 4, y_pos);
-      man->FillNtupleDColumn(1, 5, z_pos);
-      man->AddNtupleRow(1);
+      // Aggregated output, the histograms are merged over threads at Write()
+      if(outputFlag == 4){
+        if(r == k) man->FillH1(fSourcesH1, pos.z());
 
-      for(G4int c = 0; c < nbOfPMTs; c++){
-        ResetPhotonHits(c);
+        if(flag == 1){
+          man->FillH2(fHitsH2, pos.z(), pmt, weight);
+          man->FillH2(fTimeSumH2, pos.z(), pmt, weight*time);
+          G4int plane = (pmt < fDetConstruction->GetNoPMT()/2) ? 0 : 1;
+          man->FillH2(fTimesH2 + plane, pos.z(), time, weight);
+        }
       }
     }
-  }
-  else if(outputFlag == 3){
-
-    man->FillNtupleIColumn(1, 0, eventID+1);
-    man->FillNtupleIColumn(1, 1, copyNo);
-    man->FillNtupleDColumn(1, 2, x_pos);
-    man->FillNtupleDColumn(1, 3, y_pos);
-    man->FillNtupleDColumn(1, 4, z_pos);
-    man->FillNtupleDColumn(1, 5, x_dir);
-    man->FillNtupleDColumn(1, 6, y_dir);
-    man->FillNtupleDColumn(1, 7, z_dir);
-    man->FillNtupleDColumn(1, 8, time);
-    man->AddNtupleRow(1);
-
-    if ((eventID + 1) % 10000 == 0){
-
-      man->FillNtupleIColumn(2, 0, eventID+1);
-      man->FillNtupleIColumn(2, 1, hits[4]);
-      man->FillNtupleIColumn(2, 2, hits[13]);
-      man->FillNtupleDColumn(2, 3, x_pos);
-      man->FillNtupleDColumn(2, 4, y_pos);
-      man->FillNtupleDColumn(2, 5, z_pos);
-      man->AddNtupleRow(2);
-
-      for(G4int c = 0; c < nbOfPMTs; c++){
-        ResetPhotonHits(c);
+
+    // Bombs are tallied by number, as their photons may be spread over
+    // events and threads, in the two PMTs of the segment that holds them.
+    // The master writes them once the tallies are merged.
+    if(fBombs){
+      const G4ThreeVector& pos = fRecord.pos[k];
+      G4int left = fDetConstruction->GetSegment(pos);
+      G4int right = left + fDetConstruction->GetNoPMT()/2;
+
+      G4double leftHits = 0.;
+      G4double rightHits = 0.;
+      for(G4int r = k; r >= 0; r = fRecord.nextCopy[r]){
+        if(fRecord.flag[r] != 1) continue;
+        if(fRecord.pmt[r] == left) leftHits += fRecord.weight[r];
+        else if(fRecord.pmt[r] == right) rightHits += fRecord.weight[r];
       }
+
+      fBombs->AddPhoton((photonNo - 1) / fBombSize, pos, leftHits, rightHits);
     }
   }
-
-  // Freeing Memory
-  delete[] hits;
-  delete[] hits2;
 }
 
 
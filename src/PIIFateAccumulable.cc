@@ -0,0 +1,100 @@
+/// \file PIIFateAccumulable.cc
+/// \brief Implementation of the PIIFateAccumulable class
+
+#include "PIIFateAccumulable.hh"
+
+#include "G4ios.hh"
+
+#include <iomanip>
+
+namespace {
+  const char* kRoleNames[kNbOfVolumeRoles] = {
+    "Other", "Cathode", "Housing", "Reflector",
+    "Scintillator", "LightGuide", "Tab", "Tank"
+  };
+
+  const char* kFateNames[PIIFateAccumulable::kNbOfFates] = {
+    "Detected", "Housing", "Bulk absorbed", "Surface absorbed",
+    "Escaped", "Roulette", "Other"
+  };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIFateAccumulable::PIIFateAccumulable(const G4String& name)
+ : G4VAccumulable(name, G4MergeMode::kAddition)
+{
+  Reset();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIFateAccumulable::~PIIFateAccumulable()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIFateAccumulable::Merge(const G4VAccumulable& other)
+{
+  const PIIFateAccumulable& otherFates
+    = static_cast<const PIIFateAccumulable&>(other);
+
+  for (G4int r = 0; r < kNbOfVolumeRoles; r++) {
+    fSteps[r] += otherFates.fSteps[r];
+    fReflections[r] += otherFates.fReflections[r];
+    fSurfaceAbsorptions[r] += otherFates.fSurfaceAbsorptions[r];
+    fBulkAbsorptions[r] += otherFates.fBulkAbsorptions[r];
+  }
+
+  for (G4int f = 0; f < kNbOfFates; f++) {
+    fFates[f] += otherFates.fFates[f];
+    fBounces[f] += otherFates.fBounces[f];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIFateAccumulable::Reset()
+{
+  for (G4int r = 0; r < kNbOfVolumeRoles; r++) {
+    fSteps[r] = 0;
+    fReflections[r] = 0;
+    fSurfaceAbsorptions[r] = 0;
+    fBulkAbsorptions[r] = 0;
+  }
+
+  for (G4int f = 0; f < kNbOfFates; f++) {
+    fFates[f] = 0;
+    fBounces[f] = 0;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIFateAccumulable::Print() const
+{
+  G4cout << "--------------------- Photon fates ----------------------" << G4endl;
+  G4cout << std::setw(18) << "Fate" << std::setw(14) << "Photons"
+         << std::setw(14) << "Bounces/photon" << G4endl;
+
+  for (G4int f = 0; f < kNbOfFates; f++) {
+    G4double bounces = fFates[f] ? G4double(fBounces[f])/fFates[f] : 0.;
+    G4cout << std::setw(18) << kFateNames[f] << std::setw(14) << fFates[f]
+           << std::setw(14) << bounces << G4endl;
+  }
+
+  G4cout << "----------------------- Volumes -------------------------" << G4endl;
+  G4cout << std::setw(14) << "Volume" << std::setw(14) << "Steps"
+         << std::setw(13) << "Reflections" << std::setw(13) << "Surf. abs."
+         << std::setw(13) << "Bulk abs." << G4endl;
+
+  for (G4int r = 0; r < kNbOfVolumeRoles; r++) {
+    G4cout << std::setw(14) << kRoleNames[r] << std::setw(14) << fSteps[r]
+           << std::setw(13) << fReflections[r] << std::setw(13) << fSurfaceAbsorptions[r]
+           << std::setw(13) << fBulkAbsorptions[r] << G4endl;
+  }
+
+  G4cout << "---------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
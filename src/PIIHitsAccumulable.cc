@@ -0,0 +1,78 @@
+/// \file PIIHitsAccumulable.cc
+/// \brief Implementation of the PIIHitsAccumulable class
+
+#include "PIIHitsAccumulable.hh"
+
+#include <algorithm>
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIHitsAccumulable::PIIHitsAccumulable(const G4String& name)
+ : G4VAccumulable(name, G4MergeMode::kAddition)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIHitsAccumulable::~PIIHitsAccumulable()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIHitsAccumulable::Merge(const G4VAccumulable& other)
+{
+  const PIIHitsAccumulable& otherHits
+    = static_cast<const PIIHitsAccumulable&>(other);
+
+  // Workers may have been sized after a geometry change the master has not
+  // seen yet, so grow to the larger of the two
+  if (otherHits.fHits.size() > fHits.size()) {
+    fHits.resize(otherHits.fHits.size(), 0.);
+    fTimeSum.resize(otherHits.fHits.size(), 0.);
+    fTimeSum2.resize(otherHits.fHits.size(), 0.);
+  }
+
+  for (size_t c = 0; c < otherHits.fHits.size(); c++) {
+    fHits[c] += otherHits.fHits[c];
+    fTimeSum[c] += otherHits.fTimeSum[c];
+    fTimeSum2[c] += otherHits.fTimeSum2[c];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIHitsAccumulable::Reset()
+{
+  std::fill(fHits.begin(), fHits.end(), 0.);
+  std::fill(fTimeSum.begin(), fTimeSum.end(), 0.);
+  std::fill(fTimeSum2.begin(), fTimeSum2.end(), 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIHitsAccumulable::SetNoPMT(G4int nbOfPMTs)
+{
+  fHits.assign(nbOfPMTs, 0.);
+  fTimeSum.assign(nbOfPMTs, 0.);
+  fTimeSum2.assign(nbOfPMTs, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PIIHitsAccumulable::GetMeanTime(G4int PMTno) const
+{
+  if (fHits[PMTno] == 0.) return 0.;
+  return fTimeSum[PMTno]/fHits[PMTno];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PIIHitsAccumulable::GetRmsTime(G4int PMTno) const
+{
+  if (fHits[PMTno] == 0.) return 0.;
+  G4double mean = GetMeanTime(PMTno);
+  G4double variance = fTimeSum2[PMTno]/fHits[PMTno] - mean*mean;
+  return (variance > 0.) ? std::sqrt(variance) : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
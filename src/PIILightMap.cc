@@ -0,0 +1,326 @@
+/// \file PIILightMap.cc
+/// \brief Implementation of the PIILightMap class
+
+#include "PIILightMap.hh"
+
+#include "G4AutoLock.hh"
+#include "G4UnitsTable.hh"
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace {
+  // File layout: magic, version, grid sizes, box and time range, then the
+  // started counts per cell and the hit histograms, all in host byte order
+  const char  kMagic[8] = "PIILMAP";
+  const G4int kVersion = 1;
+
+  G4Mutex sharedMapMutex = G4MUTEX_INITIALIZER;
+  PIILightMap* sharedMap = nullptr;
+  G4String sharedMapFile;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIILightMap::PIILightMap(const G4String& name)
+ : G4VAccumulable(name, G4MergeMode::kAddition),
+   fNx(0), fNy(0), fNz(0), fNbOfPMTs(0), fNbOfTimeBins(0), fTimeMax(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIILightMap::~PIILightMap()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIILightMap::SetGrid(G4int nx, G4int ny, G4int nz,
+                          const G4ThreeVector& lower, const G4ThreeVector& upper,
+                          G4int nbOfPMTs, G4int nbOfTimeBins, G4double timeMax)
+{
+  fNx = nx;
+  fNy = ny;
+  fNz = nz;
+  fLower = lower;
+  fUpper = upper;
+  fNbOfPMTs = nbOfPMTs;
+  fNbOfTimeBins = nbOfTimeBins;
+  fTimeMax = timeMax;
+
+  G4int nbOfCells = fNx * fNy * fNz;
+  fStarted.assign(nbOfCells, 0.);
+  fHits.assign(GetBin(nbOfCells, 0, 0), 0.);
+  fTotals.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIILightMap::Merge(const G4VAccumulable& other)
+{
+  const PIILightMap& otherMap = static_cast<const PIILightMap&>(other);
+
+  if (otherMap.fStarted.size() != fStarted.size()
+      || otherMap.fHits.size() != fHits.size()) {
+    G4cerr << "PIILightMap::Merge: grids differ, worker map skipped" << G4endl;
+    return;
+  }
+
+  for (size_t c = 0; c < fStarted.size(); c++) {
+    fStarted[c] += otherMap.fStarted[c];
+  }
+  for (size_t b = 0; b < fHits.size(); b++) {
+    fHits[b] += otherMap.fHits[b];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIILightMap::Reset()
+{
+  std::fill(fStarted.begin(), fStarted.end(), 0.);
+  std::fill(fHits.begin(), fHits.end(), 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PIILightMap::GetCell(const G4ThreeVector& pos) const
+{
+  G4int ix = std::floor((pos.x() - fLower.x()) / (fUpper.x() - fLower.x()) * fNx);
+  G4int iy = std::floor((pos.y() - fLower.y()) / (fUpper.y() - fLower.y()) * fNy);
+  G4int iz = std::floor((pos.z() - fLower.z()) / (fUpper.z() - fLower.z()) * fNz);
+
+  if (ix < 0 || ix >= fNx || iy < 0 || iy >= fNy || iz < 0 || iz >= fNz) {
+    return -1;
+  }
+
+  return (iz * fNy + iy) * fNx + ix;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIILightMap::Fill(const G4ThreeVector& pos, G4int PMTno, G4double time,
+                       G4double weight, G4bool started)
+{
+  G4int cell = GetCell(pos);
+  if (cell < 0) return;
+
+  if (started) fStarted[cell] += 1.;
+
+  if (PMTno < 0 || PMTno >= fNbOfPMTs) return;
+
+  // Late photons go to the extra last bin
+  G4int timeBin = fNbOfTimeBins;
+  if (time < fTimeMax) {
+    timeBin = std::max(0, (G4int)(time / fTimeMax * fNbOfTimeBins));
+  }
+
+  fHits[GetBin(cell, PMTno, timeBin)] += weight;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PIILightMap::SampleHit(const G4ThreeVector& pos, G4double& time) const
+{
+  // The map only knows the segment it was generated in, the caller folds
+  // positions into it
+  if (GetCell(pos) < 0) {
+    G4ExceptionDescription msg;
+    msg << "Position " << G4BestUnit(pos, "Length")
+        << " is outside the light map, which covers " << G4BestUnit(fLower, "Length")
+        << " to " << G4BestUnit(fUpper, "Length") << ".";
+    G4Exception("PIILightMap::SampleHit()", "PIILightMap002", FatalException, msg);
+    return -1;
+  }
+
+  // Position in units of cells, relative to the first cell centre. Photons
+  // within half a cell of the walls use the outermost cells.
+  G4double f[3];
+  G4int    lo[3];
+  G4int    hi[3];
+  G4int    n[3] = { fNx, fNy, fNz };
+
+  for (G4int a = 0; a < 3; a++) {
+    f[a] = (pos[a] - fLower[a]) / (fUpper[a] - fLower[a]) * n[a] - 0.5;
+    f[a] = std::min(std::max(f[a], 0.), (G4double)(n[a] - 1));
+    lo[a] = std::min((G4int)f[a], n[a] - 1);
+    hi[a] = std::min(lo[a] + 1, n[a] - 1);
+    f[a] -= lo[a];
+  }
+
+  // Trilinear weights of the eight neighbouring cells, renormalised over the
+  // cells that saw photons during generation
+  G4int    cells[8];
+  G4double weights[8];
+  G4double norm = 0.;
+
+  for (G4int k = 0; k < 8; k++) {
+    G4int ix = (k & 1) ? hi[0] : lo[0];
+    G4int iy = (k & 2) ? hi[1] : lo[1];
+    G4int iz = (k & 4) ? hi[2] : lo[2];
+
+    cells[k] = (iz * fNy + iy) * fNx + ix;
+    weights[k] = ((k & 1) ? f[0] : 1. - f[0])
+               * ((k & 2) ? f[1] : 1. - f[1])
+               * ((k & 4) ? f[2] : 1. - f[2]);
+
+    if (fStarted[cells[k]] <= 0.) weights[k] = 0.;
+    norm += weights[k];
+  }
+
+  if (norm <= 0.) return -1;
+
+  // Pick the neighbour and the PMT in one draw, so the arrival time comes
+  // from the histogram of the same neighbour
+  G4double u = G4UniformRand() * norm;
+
+  for (G4int k = 0; k < 8; k++) {
+    if (weights[k] <= 0.) continue;
+
+    G4double scale = weights[k] / fStarted[cells[k]];
+
+    for (G4int PMTno = 0; PMTno < fNbOfPMTs; PMTno++) {
+      G4double total = fTotals[(size_t)cells[k] * fNbOfPMTs + PMTno];
+      u -= scale * total;
+      if (u >= 0.) continue;
+
+      G4double r = G4UniformRand() * total;
+      G4int timeBin = 0;
+      for (; timeBin < fNbOfTimeBins; timeBin++) {
+        r -= fHits[GetBin(cells[k], PMTno, timeBin)];
+        if (r < 0.) break;
+      }
+
+      if (timeBin == fNbOfTimeBins) {
+        time = fTimeMax;
+      }
+      else {
+        time = (timeBin + G4UniformRand()) * fTimeMax / fNbOfTimeBins;
+      }
+      return PMTno;
+    }
+  }
+
+  return -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIILightMap::SumHits()
+{
+  G4int nbOfCells = fStarted.size();
+  fTotals.assign((size_t)nbOfCells * fNbOfPMTs, 0.);
+
+  for (G4int cell = 0; cell < nbOfCells; cell++) {
+    for (G4int PMTno = 0; PMTno < fNbOfPMTs; PMTno++) {
+      G4double sum = 0.;
+      for (G4int timeBin = 0; timeBin <= fNbOfTimeBins; timeBin++) {
+        sum += fHits[GetBin(cell, PMTno, timeBin)];
+      }
+      fTotals[(size_t)cell * fNbOfPMTs + PMTno] = sum;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIILightMap::Write(const G4String& fileName) const
+{
+  std::ofstream file(fileName, std::ios::binary);
+  if (!file) {
+    G4cerr << "PIILightMap: cannot open " << fileName << " for writing" << G4endl;
+    return false;
+  }
+
+  G4int sizes[5] = { fNx, fNy, fNz, fNbOfPMTs, fNbOfTimeBins };
+  G4double ranges[7] = { fLower.x(), fLower.y(), fLower.z(),
+                         fUpper.x(), fUpper.y(), fUpper.z(), fTimeMax };
+
+  file.write(kMagic, sizeof(kMagic));
+  file.write((const char*)&kVersion, sizeof(kVersion));
+  file.write((const char*)sizes, sizeof(sizes));
+  file.write((const char*)ranges, sizeof(ranges));
+  file.write((const char*)fStarted.data(), fStarted.size() * sizeof(G4double));
+  file.write((const char*)fHits.data(), fHits.size() * sizeof(G4double));
+
+  G4cout << "Light map written to " << fileName << " ("
+         << fNx << " x " << fNy << " x " << fNz << " cells, "
+         << fNbOfPMTs << " PMTs)" << G4endl;
+
+  return file.good();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIILightMap::Read(const G4String& fileName)
+{
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file) {
+    G4cerr << "PIILightMap: cannot open " << fileName << G4endl;
+    return false;
+  }
+
+  char magic[sizeof(kMagic)];
+  G4int version = 0;
+  G4int sizes[5];
+  G4double ranges[7];
+
+  file.read(magic, sizeof(magic));
+  file.read((char*)&version, sizeof(version));
+
+  if (!file || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion) {
+    G4cerr << "PIILightMap: " << fileName << " is not a version "
+           << kVersion << " light map" << G4endl;
+    return false;
+  }
+
+  file.read((char*)sizes, sizeof(sizes));
+  file.read((char*)ranges, sizeof(ranges));
+
+  SetGrid(sizes[0], sizes[1], sizes[2],
+          G4ThreeVector(ranges[0], ranges[1], ranges[2]),
+          G4ThreeVector(ranges[3], ranges[4], ranges[5]),
+          sizes[3], sizes[4], ranges[6]);
+
+  file.read((char*)fStarted.data(), fStarted.size() * sizeof(G4double));
+  file.read((char*)fHits.data(), fHits.size() * sizeof(G4double));
+
+  if (!file) {
+    G4cerr << "PIILightMap: " << fileName << " is truncated" << G4endl;
+    fStarted.clear();
+    fHits.clear();
+    return false;
+  }
+
+  SumHits();
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const PIILightMap* PIILightMap::LoadShared(const G4String& fileName)
+{
+  // All threads sample from one read-only copy, loaded by whichever thread
+  // asks first. A different file replaces it between runs.
+  G4AutoLock lock(&sharedMapMutex);
+
+  if (sharedMap && sharedMapFile == fileName) return sharedMap;
+
+  PIILightMap* map = new PIILightMap("LightMap");
+  if (!map->Read(fileName)) {
+    delete map;
+    return nullptr;
+  }
+
+  delete sharedMap;
+  sharedMap = map;
+  sharedMapFile = fileName;
+
+  return sharedMap;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,111 @@
+/// \file PIILightMapMessenger.cc
+/// \brief Implementation of the PIILightMapMessenger class
+
+#include "PIILightMapMessenger.hh"
+#include "PIIRunAction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIILightMapMessenger::PIILightMapMessenger(PIIRunAction* runner)
+ : fRunAction(runner)
+{
+  fLightMapDirectory = new G4UIdirectory("/PII/lightmap/");
+  fLightMapDirectory->SetGuidance("Optical light-response map commands.");
+
+  fGenerateCmd = new G4UIcmdWithAString("/PII/lightmap/generate", this);
+  fGenerateCmd->SetGuidance("Tabulate PMT hit probabilities and times during the run");
+  fGenerateCmd->SetGuidance("and write the merged map to the given file at the end of it.");
+  fGenerateCmd->SetGuidance("Use with distribution 2 so that the whole segment is covered.");
+  fGenerateCmd->SetGuidance("An empty name switches generation off.");
+  fGenerateCmd->SetParameterName("generate", true);
+  fGenerateCmd->SetDefaultValue("");
+  fGenerateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fFastCmd = new G4UIcmdWithAString("/PII/lightmap/fast", this);
+  fFastCmd->SetGuidance("Skip optical tracking and sample PMT hits from the given map.");
+  fFastCmd->SetGuidance("The map must have been generated with the same number of PMTs.");
+  fFastCmd->SetGuidance("Photons in other segments are sampled at the same place in the");
+  fFastCmd->SetGuidance("map segment, with the PMTs shifted to their own segment.");
+  fFastCmd->SetGuidance("An empty name switches fast mode off.");
+  fFastCmd->SetParameterName("fast", true);
+  fFastCmd->SetDefaultValue("");
+  fFastCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fXYBinsCmd = new G4UIcmdWithAnInteger("/PII/lightmap/xyBins", this);
+  fXYBinsCmd->SetGuidance("Set number of map cells in x and in y.");
+  fXYBinsCmd->SetGuidance("Default value is 5.");
+  fXYBinsCmd->SetParameterName("xyBins", true);
+  fXYBinsCmd->SetDefaultValue(5);
+  fXYBinsCmd->SetRange("xyBins >= 1");
+  fXYBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fZBinsCmd = new G4UIcmdWithAnInteger("/PII/lightmap/zBins", this);
+  fZBinsCmd->SetGuidance("Set number of map cells along z.");
+  fZBinsCmd->SetGuidance("Default value is 40.");
+  fZBinsCmd->SetParameterName("zBins", true);
+  fZBinsCmd->SetDefaultValue(40);
+  fZBinsCmd->SetRange("zBins >= 1");
+  fZBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fTimeBinsCmd = new G4UIcmdWithAnInteger("/PII/lightmap/timeBins", this);
+  fTimeBinsCmd->SetGuidance("Set number of arrival time bins per cell and PMT.");
+  fTimeBinsCmd->SetGuidance("Default value is 50.");
+  fTimeBinsCmd->SetParameterName("timeBins", true);
+  fTimeBinsCmd->SetDefaultValue(50);
+  fTimeBinsCmd->SetRange("timeBins >= 1");
+  fTimeBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fTimeMaxCmd = new G4UIcmdWithADoubleAndUnit("/PII/lightmap/timeMax", this);
+  fTimeMaxCmd->SetGuidance("Set upper edge of the arrival time histograms.");
+  fTimeMaxCmd->SetGuidance("Later photons are kept in one overflow bin.");
+  fTimeMaxCmd->SetGuidance("Default value is 100 ns.");
+  fTimeMaxCmd->SetParameterName("timeMax", true);
+  fTimeMaxCmd->SetDefaultValue(100.);
+  fTimeMaxCmd->SetDefaultUnit("ns");
+  fTimeMaxCmd->SetRange("timeMax > 0.");
+  fTimeMaxCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIILightMapMessenger::~PIILightMapMessenger()
+{
+  delete fGenerateCmd;
+  delete fFastCmd;
+  delete fXYBinsCmd;
+  delete fZBinsCmd;
+  delete fTimeBinsCmd;
+  delete fTimeMaxCmd;
+  delete fLightMapDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIILightMapMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fGenerateCmd) {
+    fRunAction->SetLightMapOutput(newValue);
+  }
+  else if (command == fFastCmd) {
+    fRunAction->SetLightMapInput(newValue);
+  }
+  else if (command == fXYBinsCmd) {
+    fRunAction->SetLightMapXYBins(fXYBinsCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fZBinsCmd) {
+    fRunAction->SetLightMapZBins(fZBinsCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fTimeBinsCmd) {
+    fRunAction->SetLightMapTimeBins(fTimeBinsCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fTimeMaxCmd) {
+    fRunAction->SetLightMapTimeMax(fTimeMaxCmd->GetNewDoubleValue(newValue));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,36 @@
+/// \file PIIOpticalPhysicsList.cc
+/// \brief Implementation of the PIIOpticalPhysicsList class
+
+#include "PIIOpticalPhysicsList.hh"
+
+#include "G4EmStandardPhysics.hh"
+#include "G4OpticalPhysics.hh"
+#include "G4OpticalProcessIndex.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIOpticalPhysicsList::PIIOpticalPhysicsList()
+ : G4VModularPhysicsList()
+{
+  SetVerboseLevel(0);
+
+  // Standard EM defines the gamma, e-, e+ and proton the production cuts
+  // are converted for, and the /process/em/ commands of the macros
+  RegisterPhysics(new G4EmStandardPhysics(0));
+
+  // Transportation is added by the base class; primaries are optical
+  // photons, so no process produces them inside the detector
+  G4OpticalPhysics* opticalPhysics = new G4OpticalPhysics();
+  opticalPhysics->Configure(kCerenkov, false);
+  opticalPhysics->Configure(kScintillation, false);
+  opticalPhysics->Configure(kMieHG, false);
+  opticalPhysics->Configure(kWLS, false);
+  RegisterPhysics(opticalPhysics);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIOpticalPhysicsList::~PIIOpticalPhysicsList()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
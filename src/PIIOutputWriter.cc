@@ -0,0 +1,149 @@
+/// \file PIIOutputWriter.cc
+/// \brief Implementation of the PIIOutputWriter class
+
+#include "PIIOutputWriter.hh"
+
+#include "G4VAnalysisManager.hh"
+#include "G4ios.hh"
+
+#include <chrono>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIOutputWriter::PIIOutputWriter(G4int capacity)
+ : fHead(0), fTail(0), fRunning(false), fFailed(false), fStalls(0), fSpill(nullptr)
+{
+  // Round up to a power of two so that slots can be masked
+  size_t size = 1;
+  while (size < (size_t)capacity) size <<= 1;
+
+  fBuffer.resize(size);
+  fMask = size - 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIOutputWriter::~PIIOutputWriter()
+{
+  // Rows of a run that did not end are dropped
+  Stop(nullptr);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIIOutputWriter::Start()
+{
+  if (fRunning) return true;
+
+  // Removed by the system once closed
+  fSpill = std::tmpfile();
+  if (!fSpill) {
+    G4Exception("PIIOutputWriter::Start()", "PIIOutput002", JustWarning,
+                "No temporary file for the writer thread, rows are written directly.");
+    return false;
+  }
+
+  fHead = 0;
+  fTail = 0;
+  fStalls = 0;
+  fFailed = false;
+  fRunning = true;
+  fThread = std::thread(&PIIOutputWriter::Run, this);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIOutputWriter::Stop(G4VAnalysisManager* man)
+{
+  if (!fRunning) return;
+
+  // The writer drains everything left in the ring before it returns
+  fRunning = false;
+  fThread.join();
+
+  if (fFailed) {
+    G4Exception("PIIOutputWriter::Stop()", "PIIOutput003", JustWarning,
+                "Writing the spill file failed, the rows of this run are incomplete.");
+  }
+
+  // Fill the spilled rows on this thread, which owns the manager
+  if (man) {
+    std::rewind(fSpill);
+    PIIOutputRecord row;
+    while (std::fread(&row, sizeof(row), 1, fSpill) == 1) {
+      Fill(man, row);
+    }
+  }
+
+  std::fclose(fSpill);
+  fSpill = nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIOutputWriter::Push(const PIIOutputRecord& row)
+{
+  size_t head = fHead.load(std::memory_order_relaxed);
+
+  // Backpressure: wait for the writer to free a slot
+  if (head - fTail.load(std::memory_order_acquire) > fMask) {
+    fStalls++;
+    while (head - fTail.load(std::memory_order_acquire) > fMask) {
+      std::this_thread::yield();
+    }
+  }
+
+  fBuffer[head & fMask] = row;
+  fHead.store(head + 1, std::memory_order_release);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIOutputWriter::Fill(G4VAnalysisManager* man, const PIIOutputRecord& row)
+{
+  for (G4int c = 0; c < row.nInts; c++) {
+    man->FillNtupleIColumn(row.ntupleId, c, row.ints[c]);
+  }
+  for (G4int c = 0; c < row.nDoubles; c++) {
+    man->FillNtupleDColumn(row.ntupleId, row.nInts + c, row.doubles[c]);
+  }
+  man->AddNtupleRow(row.ntupleId);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PIIOutputWriter::Drain()
+{
+  size_t tail = fTail.load(std::memory_order_relaxed);
+  size_t head = fHead.load(std::memory_order_acquire);
+
+  // Hand slots back to the producer in chunks rather than one by one
+  for (size_t slot = tail; slot != head; slot++) {
+    if (std::fwrite(&fBuffer[slot & fMask], sizeof(PIIOutputRecord), 1, fSpill) != 1) {
+      fFailed = true;
+    }
+    if (((slot + 1) & 1023) == 0) {
+      fTail.store(slot + 1, std::memory_order_release);
+    }
+  }
+  fTail.store(head, std::memory_order_release);
+
+  return head - tail;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIOutputWriter::Run()
+{
+  while (fRunning) {
+    if (Drain() == 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  // Rows pushed before Stop() was called
+  Drain();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
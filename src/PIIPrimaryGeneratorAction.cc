@@ -4,11 +4,14 @@
 #include "PIIPrimaryGeneratorAction.hh"
 #include "PIIPrimaryGeneratorMessenger.hh"
 #include "PIIEventAction.hh"
+#include "PIIDirectionBias.hh"
 
 #include "G4LogicalVolumeStore.hh"
 #include "G4LogicalVolume.hh"
 #include "G4Box.hh"
 #include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
@@ -18,10 +21,55 @@
 #include "globals.hh"
 #include "G4PhysicalConstants.hh"
 #include <sstream>
+#include <stdint.h>
 
 #include "CLHEP/Units/SystemOfUnits.h"
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+namespace {
+
+  // Counter-based hashing (SplitMix64): the same (seed, stream, counter)
+  // always gives the same value, whatever was generated before it
+  const uint64_t kEventStream = 0x9E3779B97F4A7C15ULL;
+  const uint64_t kBombStream  = 0xD1B54A32D192ED03ULL;
+
+  uint64_t Mix64(uint64_t z)
+  {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t Hash(G4long seed, uint64_t stream, G4long counter)
+  {
+    return Mix64(Mix64((uint64_t)seed + stream) + (uint64_t)counter * kEventStream);
+  }
+
+  // Uniform in [0, 1) from the top 53 bits
+  G4double HashUniform(G4long seed, uint64_t stream, G4long counter)
+  {
+    return (Hash(seed, stream, counter) >> 11) * (1.0/9007199254740992.0);
+  }
+
+  void SeedEngine(G4long seed, G4long eventNo)
+  {
+    uint64_t key = Hash(seed, kEventStream, eventNo);
+
+    // Zero terminates the seed list, so keep every seed non-zero
+    long seeds[5];
+    for (G4int i = 0; i < 4; i++) {
+      seeds[i] = (long)(Mix64(key + i + 1) & 0x7fffffff);
+      if (seeds[i] == 0) seeds[i] = 1;
+    }
+    seeds[4] = 0;
+
+    G4Random::setTheSeeds(seeds);
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 PIIPrimaryGeneratorAction::PIIPrimaryGeneratorAction(PIIEventAction* eventAction)
  : G4VUserPrimaryGeneratorAction(), fEventAction(eventAction)
 {
@@ -59,6 +107,11 @@ void PIIPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   // This function is called at the begining of event
 
   G4int eventID = anEvent->GetEventID();
+  G4long eventNo = fEventOffset + eventID;
+
+  if (fPerEventSeeds) {
+    SeedEngine(fRunSeed, eventNo);
+  }
   G4int fRowNum = fEventAction->GetNoRows();
   G4int fColNum = fEventAction->GetNoCols();
 
@@ -69,120 +122,145 @@ void PIIPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 
   // Get values from commands
 
-  G4ThreeVector pos = GetPosition();
-  G4ThreeVector dir;
+  G4ThreeVector posCmd = GetPosition();
   G4bool iso = GetIsotropic();
   G4int distrb = GetDistribution();
   G4bool randoms = GetRandomXY();
+  G4int nPhotons = GetPhotonsPerEvent();
+  G4int bombSize = GetBombSize();
+
+  // The event action needs the batching to number photons and close bombs
+
+  fEventAction->SetPhotonsPerEvent(nPhotons);
+  fEventAction->SetBombSize(bombSize);
+  fEventAction->SetEventOffset(fEventOffset);
+
+  // Direction biasing of the run (/PII/bias/direction), or none
+  const PIIDirectionBias* bias = fEventAction->GetDirectionBias();
+  G4PrimaryVertex* vertex = nullptr;
 
   // Set up values
 
   G4double reflectorHeight = 14.478*cm; // tank height from cross section
   G4double chamberLength = 121.92*cm; // length of tank
 
-  G4double randDistx = 1. - 2*G4UniformRand();
-  G4double randDisty = 1. - 2*G4UniformRand();
-  G4double randDistz = 1. - 2*G4UniformRand();
+  // One primary vertex per photon, all in the same event
 
-  G4double randPositionx = randDistx * reflectorHeight * 0.499;
-  G4double randPositiony = randDisty * reflectorHeight * 0.499;
-  G4double randPositionz = randDistz * chamberLength * 0.499;
+  for (G4int k = 0; k < nPhotons; k++) {
 
-  G4double randMomentumx = 1. - 2*G4UniformRand();
-  G4double randMomentumy = 1. - 2*G4UniformRand();
-  G4double randMomentumz = 1. - 2*G4UniformRand();
+    G4long photonID = eventNo * nPhotons + k;
 
-  G4double cosTheta = 1. - 2.*G4UniformRand();
-  G4double sinTheta = sqrt(1. - cosTheta*cosTheta);
-  G4double phi = twopi * G4UniformRand();
-  dir = G4ThreeVector( (sinTheta * cos(phi)), (sinTheta * sin(phi)), cosTheta);
+    G4ThreeVector pos = posCmd;
+    G4ThreeVector dir;
 
-  G4ThreeVector polar = G4ThreeVector(randMomentumx, randMomentumy, randMomentumz);
+    G4double randDistx = 1. - 2*G4UniformRand();
+    G4double randDisty = 1. - 2*G4UniformRand();
+    G4double randDistz = 1. - 2*G4UniformRand();
 
-  if (distrb == 1) {
+    G4double randPositionx = randDistx * reflectorHeight * 0.499;
+    G4double randPositiony = randDisty * reflectorHeight * 0.499;
+    G4double randPositionz = randDistz * chamberLength * 0.499;
 
-    if (pos == G4ThreeVector(0, 0, 0)) {
-      if (randoms == true) {
-        pos = G4ThreeVector(randPositionx, randPositiony, 0);
-      }
-      else{
-        pos = G4ThreeVector(0, 0, 0);
-      }
-    }
+    G4double randMomentumx = 1. - 2*G4UniformRand();
+    G4double randMomentumy = 1. - 2*G4UniformRand();
+    G4double randMomentumz = 1. - 2*G4UniformRand();
+
+    G4double cosTheta = 1. - 2.*G4UniformRand();
+    G4double sinTheta = sqrt(1. - cosTheta*cosTheta);
+    G4double phi = twopi * G4UniformRand();
     dir = G4ThreeVector( (sinTheta * cos(phi)), (sinTheta * sin(phi)), cosTheta);
 
-    fParticleGun->SetParticlePosition(pos);
-    fParticleGun->SetParticleMomentumDirection(dir);
+    G4ThreeVector polar = G4ThreeVector(randMomentumx, randMomentumy, randMomentumz);
 
-    fLastPos = pos;
+    // Isotropic directions are redrawn from the biased density, the photon
+    // carries the importance weight of its direction
+    G4double weight = 1.;
+    if (bias && ((distrb >= 1 && distrb <= 3) || iso)) {
+      weight = bias->Sample(dir);
+    }
 
-  }
+    if (distrb == 1) {
 
-  else if (distrb == 2) {
+      if (pos == G4ThreeVector(0, 0, 0)) {
+        if (randoms == true) {
+          pos = G4ThreeVector(randPositionx, randPositiony, 0);
+        }
+        else{
+          pos = G4ThreeVector(0, 0, 0);
+        }
+      }
 
-    pos = G4ThreeVector(randPositionx, randPositiony, randPositionz);
-    dir = G4ThreeVector( (sinTheta * cos(phi)), (sinTheta * sin(phi)), cosTheta);
+      fParticleGun->SetParticlePosition(pos);
+      fParticleGun->SetParticleMomentumDirection(dir);
 
-    fParticleGun->SetParticlePosition(pos);
-    fParticleGun->SetParticleMomentumDirection(dir);
+      fLastPos = pos;
 
-    fLastPos = pos;
-  }
+    }
 
-  else if (distrb == 3) {
+    else if (distrb == 2) {
 
-    G4int bombFlag;
-    G4double zloc;
+      pos = G4ThreeVector(randPositionx, randPositiony, randPositionz);
 
-    if (eventID % 10000 == 0){
-      bombFlag = 1;
-      zloc = chamberLength*G4UniformRand();
-    }
-    else{
-      bombFlag = 0;
-    }
+      fParticleGun->SetParticlePosition(pos);
+      fParticleGun->SetParticleMomentumDirection(dir);
 
-    if (bombFlag == 1){
-      pos = G4ThreeVector(6.239*cm, 6.239*cm, (-0.5*chamberLength + zloc));
-    }
-    else {
-      pos = fLastPos;
+      fLastPos = pos;
     }
 
-    dir = G4ThreeVector( (sinTheta * cos(phi)), (sinTheta * sin(phi)), cosTheta);
-
-    fParticleGun->SetParticlePosition(pos);
-    fParticleGun->SetParticleMomentumDirection(dir);
+    else if (distrb == 3) {
 
-    fLastPos = pos;
-  }
+      // A new bomb starts every bombSize photons, counted over the whole run
 
-  else {
+      // With per-event seeds the bomb position is a function of the bomb
+      // number, as its photons may be spread over threads and processes
 
-    if (pos == G4ThreeVector(0, 0, 0)) {
-      if (randoms == true) {
-        pos = G4ThreeVector(randPositionx, randPositiony, 0);
+      if (fPerEventSeeds) {
+        G4double zloc = chamberLength*HashUniform(fRunSeed, kBombStream, photonID / bombSize);
+        pos = G4ThreeVector(6.239*cm, 6.239*cm, (-0.5*chamberLength + zloc));
       }
-      else{
-        pos = G4ThreeVector(0, 0, 0);
+      else if (photonID % bombSize == 0){
+        G4double zloc = chamberLength*G4UniformRand();
+        pos = G4ThreeVector(6.239*cm, 6.239*cm, (-0.5*chamberLength + zloc));
+      }
+      else {
+        pos = fLastPos;
       }
-    }
-
-    fParticleGun->SetParticlePosition(pos);
 
-    if (iso == true) {
+      fParticleGun->SetParticlePosition(pos);
       fParticleGun->SetParticleMomentumDirection(dir);
+
+      fLastPos = pos;
     }
+
     else {
-      fParticleGun->SetParticleMomentumDirection(G4ThreeVector((sinTheta * cos(phi)), (sinTheta * sin(phi)), -1));
+
+      if (pos == G4ThreeVector(0, 0, 0)) {
+        if (randoms == true) {
+          pos = G4ThreeVector(randPositionx, randPositiony, 0);
+        }
+        else{
+          pos = G4ThreeVector(0, 0, 0);
+        }
+      }
+
+      fParticleGun->SetParticlePosition(pos);
+
+      if (iso == true) {
+        fParticleGun->SetParticleMomentumDirection(dir);
+      }
+      else {
+        fParticleGun->SetParticleMomentumDirection(G4ThreeVector((sinTheta * cos(phi)), (sinTheta * sin(phi)), -1));
+      }
     }
-  }
 
-  fParticleGun->SetParticlePolarization(polar);
-  fParticleGun->GeneratePrimaryVertex(anEvent);
+    fParticleGun->SetParticlePolarization(polar);
+    fParticleGun->GeneratePrimaryVertex(anEvent);
 
-  fEventAction->SetPos(pos);
-  fEventAction->SetDirection(dir);
+    if (bias) {
+      vertex = vertex ? vertex->GetNext() : anEvent->GetPrimaryVertex(0);
+      vertex->GetPrimary()->SetWeight(weight);
+    }
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -207,6 +285,26 @@ void PIIPrimaryGeneratorAction::SetRandomXY(G4bool rands){
   fRandomXY = rands;
 }
 
+void PIIPrimaryGeneratorAction::SetPhotonsPerEvent(G4int nPhotons){
+  fPhotonsPerEvent = nPhotons;
+}
+
+void PIIPrimaryGeneratorAction::SetBombSize(G4int bombSize){
+  fBombSize = bombSize;
+}
+
+void PIIPrimaryGeneratorAction::SetRunSeed(G4long seed){
+  fRunSeed = seed;
+}
+
+void PIIPrimaryGeneratorAction::SetEventOffset(G4long offset){
+  fEventOffset = offset;
+}
+
+void PIIPrimaryGeneratorAction::SetPerEventSeeds(G4bool perEvent){
+  fPerEventSeeds = perEvent;
+}
+
 void PIIPrimaryGeneratorAction::SetDefaults(){
 
   fPos = G4ThreeVector(0, 0, 0);
@@ -214,6 +312,11 @@ void PIIPrimaryGeneratorAction::SetDefaults(){
   fDistrb = 2;
   fIsotropic = true;
   fRandomXY = false;
+  fPhotonsPerEvent = 1;
+  fBombSize = 10000;
+  fRunSeed = 1;
+  fEventOffset = 0;
+  fPerEventSeeds = true;
 
 }
 
@@ -236,3 +339,23 @@ G4bool PIIPrimaryGeneratorAction::GetIsotropic(){
 G4bool PIIPrimaryGeneratorAction::GetRandomXY(){
   return fRandomXY;
 }
+
+G4int PIIPrimaryGeneratorAction::GetPhotonsPerEvent(){
+  return fPhotonsPerEvent;
+}
+
+G4int PIIPrimaryGeneratorAction::GetBombSize(){
+  return fBombSize;
+}
+
+G4long PIIPrimaryGeneratorAction::GetRunSeed(){
+  return fRunSeed;
+}
+
+G4long PIIPrimaryGeneratorAction::GetEventOffset(){
+  return fEventOffset;
+}
+
+G4bool PIIPrimaryGeneratorAction::GetPerEventSeeds(){
+  return fPerEventSeeds;
+}
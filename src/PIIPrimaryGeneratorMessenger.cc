@@ -28,7 +28,6 @@ PIIPrimaryGeneratorMessenger::PIIPrimaryGeneratorMessenger(PIIPrimaryGeneratorAc
   fPositionCmd->SetDefaultValue(G4ThreeVector(0, -7.239, 0));
   fPositionCmd->SetDefaultUnit("cm");
   fPositionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-  fPositionCmd->SetToBeBroadcasted(false);
 
   fDivisionsCmd = new G4UIcmdWithAnInteger("/PII/generator/division", this);
   fDivisionsCmd->SetGuidance("Set number of divisions.");
@@ -38,7 +37,6 @@ PIIPrimaryGeneratorMessenger::PIIPrimaryGeneratorMessenger(PIIPrimaryGeneratorAc
   fDivisionsCmd->SetDefaultValue(1);
   fDivisionsCmd->SetRange("divisions >= 1");
   fDivisionsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-  fDivisionsCmd->SetToBeBroadcasted(false);
 
   fIsotropicCmd = new G4UIcmdWithABool("/PII/generator/isotropic", this);
   fIsotropicCmd->SetGuidance("Set whether source is isotropic.");
@@ -47,7 +45,6 @@ PIIPrimaryGeneratorMessenger::PIIPrimaryGeneratorMessenger(PIIPrimaryGeneratorAc
   fIsotropicCmd->SetParameterName("isotropic", true);
   fIsotropicCmd->SetDefaultValue(true);
   fIsotropicCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-  fIsotropicCmd->SetToBeBroadcasted(false);
 
   fDistributionCmd = new G4UIcmdWithAnInteger("/PII/generator/distribution", this);
   fDistributionCmd->SetGuidance("Set particle distribution:");
@@ -58,7 +55,6 @@ PIIPrimaryGeneratorMessenger::PIIPrimaryGeneratorMessenger(PIIPrimaryGeneratorAc
   fDistributionCmd->SetParameterName("distribution", true);
   fDistributionCmd->SetDefaultValue(1);
   fDistributionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-  fDistributionCmd->SetToBeBroadcasted(false);
 
   fRandomXYCmd = new G4UIcmdWithABool("/PII/generator/randomXY", this);
   fRandomXYCmd->SetGuidance("Set whether distribution is random in x and y, or centered on z-axis");
@@ -67,10 +63,56 @@ PIIPrimaryGeneratorMessenger::PIIPrimaryGeneratorMessenger(PIIPrimaryGeneratorAc
   fRandomXYCmd->SetDefaultValue(false);
   fRandomXYCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 
+  fPhotonsPerEventCmd = new G4UIcmdWithAnInteger("/PII/generator/photonsPerEvent", this);
+  fPhotonsPerEventCmd->SetGuidance("Set number of photons generated in each event.");
+  fPhotonsPerEventCmd->SetGuidance("Each photon gets its own primary vertex and its own output row.");
+  fPhotonsPerEventCmd->SetGuidance("Set equal to bombSize to simulate one bomb per event.");
+  fPhotonsPerEventCmd->SetGuidance("Default value is 1.");
+  fPhotonsPerEventCmd->SetParameterName("photonsPerEvent", true);
+  fPhotonsPerEventCmd->SetDefaultValue(1);
+  fPhotonsPerEventCmd->SetRange("photonsPerEvent >= 1");
+  fPhotonsPerEventCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fBombSizeCmd = new G4UIcmdWithAnInteger("/PII/generator/bombSize", this);
+  fBombSizeCmd->SetGuidance("Set number of photons in one bomb (distribution 3).");
+  fBombSizeCmd->SetGuidance("Bomb output rows are written every bombSize photons.");
+  fBombSizeCmd->SetGuidance("Default value is 10000.");
+  fBombSizeCmd->SetParameterName("bombSize", true);
+  fBombSizeCmd->SetDefaultValue(10000);
+  fBombSizeCmd->SetRange("bombSize >= 1");
+  fBombSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
   fDefaultsCmd = new G4UIcommand("/PII/generator/defaults",this);
   fDefaultsCmd->SetGuidance("Set all generator values to defaults.");
   fDefaultsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
-  fDefaultsCmd->SetToBeBroadcasted(false);
+
+  fRandomDir = new G4UIdirectory("/PII/random/");
+  fRandomDir->SetGuidance("Reproducible per-event random seeds");
+
+  fRunSeedCmd = new G4UIcmdWithAnInteger("/PII/random/runSeed", this);
+  fRunSeedCmd->SetGuidance("Set seed of the run.");
+  fRunSeedCmd->SetGuidance("Each event is seeded from this value and its global event number.");
+  fRunSeedCmd->SetGuidance("Default value is 1.");
+  fRunSeedCmd->SetParameterName("runSeed", true);
+  fRunSeedCmd->SetDefaultValue(1);
+  fRunSeedCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fEventOffsetCmd = new G4UIcmdWithAnInteger("/PII/random/eventOffset", this);
+  fEventOffsetCmd->SetGuidance("Set global number of the first event of this run.");
+  fEventOffsetCmd->SetGuidance("Processes sharing a run seed take disjoint event ranges.");
+  fEventOffsetCmd->SetGuidance("Default value is 0.");
+  fEventOffsetCmd->SetParameterName("eventOffset", true);
+  fEventOffsetCmd->SetDefaultValue(0);
+  fEventOffsetCmd->SetRange("eventOffset >= 0");
+  fEventOffsetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fPerEventSeedsCmd = new G4UIcmdWithABool("/PII/random/perEvent", this);
+  fPerEventSeedsCmd->SetGuidance("Set whether every event is reseeded from the run seed.");
+  fPerEventSeedsCmd->SetGuidance("If false, events follow the engine stream set by /random/setSeeds.");
+  fPerEventSeedsCmd->SetGuidance("Default value is true.");
+  fPerEventSeedsCmd->SetParameterName("perEvent", true);
+  fPerEventSeedsCmd->SetDefaultValue(true);
+  fPerEventSeedsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 
 }
 
@@ -83,7 +125,13 @@ PIIPrimaryGeneratorMessenger::~PIIPrimaryGeneratorMessenger()
   delete fDivisionsCmd;
   delete fIsotropicCmd;
   delete fDistributionCmd;
+  delete fPhotonsPerEventCmd;
+  delete fBombSizeCmd;
   delete fDefaultsCmd;
+  delete fRunSeedCmd;
+  delete fEventOffsetCmd;
+  delete fPerEventSeedsCmd;
+  delete fRandomDir;
 
 }
 
@@ -110,9 +158,29 @@ void PIIPrimaryGeneratorMessenger::SetNewValue(G4UIcommand* command, G4String ne
     fPrimaryGenerator->SetRandomXY(fRandomXYCmd->GetNewBoolValue(newValue));
   }
 
+  else if (command == fPhotonsPerEventCmd) {
+    fPrimaryGenerator->SetPhotonsPerEvent(fPhotonsPerEventCmd->GetNewIntValue(newValue));
+  }
+
+  else if (command == fBombSizeCmd) {
+    fPrimaryGenerator->SetBombSize(fBombSizeCmd->GetNewIntValue(newValue));
+  }
+
   else if (command == fDefaultsCmd) {
     fPrimaryGenerator->SetDefaults();
   }
+
+  else if (command == fRunSeedCmd) {
+    fPrimaryGenerator->SetRunSeed(fRunSeedCmd->GetNewIntValue(newValue));
+  }
+
+  else if (command == fEventOffsetCmd) {
+    fPrimaryGenerator->SetEventOffset(fEventOffsetCmd->GetNewIntValue(newValue));
+  }
+
+  else if (command == fPerEventSeedsCmd) {
+    fPrimaryGenerator->SetPerEventSeeds(fPerEventSeedsCmd->GetNewBoolValue(newValue));
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
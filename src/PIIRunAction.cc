@@ -3,40 +3,81 @@
 
 #include "PIIRunAction.hh"
 #include "PIIRunMessenger.hh"
+#include "PIIDetectorConstruction.hh"
 #include "PIIEventAction.hh"
 #include "PIISteppingAction.hh"
 #include "PIIAnalysis.hh"
+#include "PIIOutputWriter.hh"
+#include "PIIStackingAction.hh"
+#include "PIILightMapMessenger.hh"
+#include "PIIUniverseMessenger.hh"
+#include "PIIBiasingMessenger.hh"
+#include "PIIPrimaryGeneratorAction.hh"
+#include "PIIScintFastModel.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
+#include "G4AccumulableManager.hh"
+#include "G4Threading.hh"
 #include "G4ios.hh"
 #include "G4Types.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
 #include "Randomize.hh"
 
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-PIIRunAction::PIIRunAction(PIISteppingAction* stepAction, PIIEventAction* eventAction)
- : G4UserRunAction(), fStepAction(stepAction), fEventAction(eventAction)
+PIIRunAction::PIIRunAction(PIIDetectorConstruction* detConstruction,
+                           PIISteppingAction* stepAction, PIIEventAction* eventAction,
+                           PIIStackingAction* stackAction)
+ : G4UserRunAction(), fDetConstruction(detConstruction),
+   fStepAction(stepAction), fEventAction(eventAction), fStackAction(stackAction),
+   fPMTHits("PMTHits"), fLightMap("LightMap"), fNbOfSteps("NbOfSteps", 0),
+   fNbOfDetected("NbOfDetected", 0.), fNbOfHousing("NbOfHousing", 0.),
+   fNbOfLost("NbOfLost", 0.), fFates("Fates"), fUniverseHits("Universes"),
+   fBombs("Bombs"), fGeometryNtuple(-1), fPhotonNtuple(-1), fUniverseNtuple(-1),
+   fBombNtuple(-1), fSourcesH1(-1), fHitsH2(-1), fTimeSumH2(-1), fTimesH2(-1)
 {
 
   fRunMessenger = new PIIRunMessenger(this);
+  fLightMapMessenger = new PIILightMapMessenger(this);
+  fUniverseMessenger = new PIIUniverseMessenger(this);
+  fBiasingMessenger = new PIIBiasingMessenger(this);
+  fOutputWriter = new PIIOutputWriter();
   SetDefaults();
 
+  // Register run-level counters, merged from the workers into the master
+  G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
+  accumulableManager->RegisterAccumulable(&fPMTHits);
+  accumulableManager->RegisterAccumulable(&fLightMap);
+  accumulableManager->RegisterAccumulable(fNbOfSteps);
+  accumulableManager->RegisterAccumulable(fNbOfDetected);
+  accumulableManager->RegisterAccumulable(fNbOfHousing);
+  accumulableManager->RegisterAccumulable(fNbOfLost);
+  accumulableManager->RegisterAccumulable(&fFates);
+  accumulableManager->RegisterAccumulable(&fUniverseHits);
+  accumulableManager->RegisterAccumulable(&fBombs);
+
   // set printing event number per each 100 events
   G4RunManager::GetRunManager()->SetPrintProgress(100000);
 
-  // Create analysis manager for recording hits
-  G4AnalysisManager* man = G4AnalysisManager::Instance();
-
-  // Set up analysis manager
-  man->SetVerboseLevel(1);
+  // The analysis manager is created at the start of each run, once
+  // /PII/output/format has been applied, and deleted at its end
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 PIIRunAction::~PIIRunAction()
 {
-  delete G4AnalysisManager::Instance();
+  delete fOutputWriter;
+  delete fLightMapMessenger;
+  delete fUniverseMessenger;
+  delete fBiasingMessenger;
+  PIIAnalysis::DeleteInstance();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -50,80 +91,463 @@ void PIIRunAction::BeginOfRunAction(const G4Run* aRun)
   //G4int seeder = G4UniformRand() * 1000;
   //G4Random::setTheSeed(fRunNum*seeder + 1); // set unique random seed for run --- can't be 0
 
+  // Path summaries and universes are tallied from the steps in the
+  // scintillator, which the fast model replaces by one step per photon
+  if (PIIScintFastModel::IsEnabled() && (fPathSummary || !fUniverses.empty())) {
+    G4ExceptionDescription msg;
+    msg << (fPathSummary ? "/PII/output/pathSummary" : "/PII/universe/add")
+        << " needs full tracking, set /PII/fastsim/scintillator false.";
+    G4Exception("PIIRunAction::BeginOfRunAction()", "PIIFastSim001",
+                FatalException, msg);
+  }
+
   // Get analysis manager and open output file
-  G4AnalysisManager* man = G4AnalysisManager::Instance();
-  man->OpenFile("PII");
+  G4VAnalysisManager* man = PIIAnalysis::Instance();
+  man->SetVerboseLevel(1);
+  man->SetCompressionLevel(fCompression);
+  // A label (/PII/output/label, set per sweep point) gives the run its own file
+  man->OpenFile(fLabel != "" ? "PII_" + fLabel : G4String("PII"));
 
-  man->CreateNtuple("Geometry" + filename, "Geometry Info");
+  // The manager is new for every run, see EndOfRunAction(), so a sweep
+  // books each ntuple once per run and the IDs are those returned here
+  fGeometryNtuple = man->CreateNtuple("Geometry" + filename, "Geometry Info");
   man->CreateNtupleIColumn("Number of PMTs");
   man->CreateNtupleIColumn("Number of Rows");
   man->CreateNtupleIColumn("Number of Columns");
   man->FinishNtuple();
 
-  if (fOutputs == 1){
-    man->CreateNtuple("PII_photons_" + filename + fRunid, "Photon Tracking");
-    man->CreateNtupleIColumn("PMT Hit");
-    man->CreateNtupleIColumn("Event Number");
-    man->CreateNtupleDColumn("X position");
-    man->CreateNtupleDColumn("Y position");
-    man->CreateNtupleDColumn("Z position");
-    man->CreateNtupleDColumn("X direction");
-    man->CreateNtupleDColumn("Y direction");
-    man->CreateNtupleDColumn("Z direction");
-    man->CreateNtupleDColumn("Time");
+  // The bomb ntuple follows the photon ntuple when there are both
+  fPhotonNtuple = -1;
+  fBombNtuple = -1;
+  if (fOutputs == 1 || fOutputs == 3) CreatePhotonNtuple(man);
+  if (fOutputs == 2 || fOutputs == 3) CreateBombNtuple(man);
+
+  G4int nbOfPMTs = fDetConstruction->GetNoPMT();
+
+  // Weighted hits per universe and PMT, one row each, the nominal run first
+  fUniverseNtuple = -1;
+  if (!fUniverses.empty()) {
+    fUniverseNtuple = man->CreateNtuple("PII_universes_" + filename + fRunid,
+                                        "Universe Tallies");
+    man->CreateNtupleSColumn("Universe");
+    man->CreateNtupleIColumn("PMT");
+    man->CreateNtupleDColumn("Hits");
+    man->CreateNtupleDColumn("Photons");
     man->FinishNtuple();
   }
 
-  else if (fOutputs == 2){
-    man->CreateNtuple("PII_bombs_" + filename + fRunid, "Bomb Tracking");
-    man->CreateNtupleIColumn("Event Number");
-    man->CreateNtupleIColumn("Left PMT");
-    man->CreateNtupleIColumn("Right PMT");
-    man->CreateNtupleDColumn("X position");
-    man->CreateNtupleDColumn("Y position");
-    man->CreateNtupleDColumn("Z position");
-    man->FinishNtuple();
+  // Aggregated output: counts binned in source z instead of photon rows.
+  // Booked every run on the new manager, for the PMTs and binning of the run.
+  fSourcesH1 = fHitsH2 = fTimeSumH2 = fTimesH2 = -1;
+  if (fOutputs == 4){
+    G4double chamberLength = 121.92*cm; // length of tank
+    G4double zMin = -0.5*chamberLength;
+    G4double zMax = 0.5*chamberLength;
+
+    fSourcesH1 = man->CreateH1("PII_sources_" + filename + fRunid,
+                               "Photons generated vs source z",
+                               fZBins, zMin, zMax, "cm");
+
+    fHitsH2 = man->CreateH2("PII_hits_" + filename + fRunid, "PMT hits vs source z",
+                            fZBins, zMin, zMax, nbOfPMTs, -0.5, nbOfPMTs - 0.5, "cm");
+
+    // Hit times summed per PMT, divided by PII_hits gives the mean time
+    fTimeSumH2 = man->CreateH2("PII_timesum_" + filename + fRunid,
+                               "Summed arrival time vs source z",
+                               fZBins, zMin, zMax, nbOfPMTs, -0.5, nbOfPMTs - 0.5, "cm");
+
+    // Arrival time spectra, one per PMT plane: left in fTimesH2, right in fTimesH2 + 1.
+    // One per PMT would take zBins*timeBins doubles for each of the PMTs.
+    const char* planes[2] = {"left", "right"};
+    for(G4int p = 0; p < 2; p++){
+      G4int id = man->CreateH2("PII_times_" + filename + fRunid + "_" + planes[p],
+                    G4String("Arrival time vs source z in the ") + planes[p] + " PMTs",
+                    fZBins, zMin, zMax, fTimeBins, 0., fTimeMax, "cm", "ns");
+      if (p == 0) fTimesH2 = id;
+    }
   }
 
-  else if (fOutputs == 3){
-    man->CreateNtuple("PII_photons_" + filename + fRunid, "Photon Tracking");
-    man->CreateNtupleIColumn("PMT Hit");
-    man->CreateNtupleIColumn("Event Number");
-    man->CreateNtupleDColumn("X position");
-    man->CreateNtupleDColumn("Y position");
-    man->CreateNtupleDColumn("Z position");
-    man->CreateNtupleDColumn("X direction");
-    man->CreateNtupleDColumn("Y direction");
-    man->CreateNtupleDColumn("Z direction");
-    man->CreateNtupleDColumn("Time");
-    man->FinishNtuple();
+  if (fDirectionBias.GetMode() == PIIDirectionBias::kMap && fDirectionBias.IsEmpty()) {
+    G4Exception("PIIRunAction::BeginOfRunAction()", "PIIDirectionBias004",
+                FatalException, "/PII/bias/direction map needs /PII/bias/directionMap.");
+  }
 
-    man->CreateNtuple("PII_bombs_" + filename + fRunid, "Bomb Tracking");
-    man->CreateNtupleIColumn("Event Number");
-    man->CreateNtupleIColumn("Left PMT");
-    man->CreateNtupleIColumn("Right PMT");
-    man->CreateNtupleDColumn("X position");
-    man->CreateNtupleDColumn("Y position");
-    man->CreateNtupleDColumn("Z position");
-    man->FinishNtuple();
+  // Size and reset the run-level counters, the geometry may have changed
+  fPMTHits.SetNoPMT(nbOfPMTs);
+  fUniverseHits.SetUniverses(fUniverses, nbOfPMTs);
+
+  // The light map covers one segment around the origin, like distribution 2
+  if (fLightMapOutput != "") {
+    G4double reflectorHeight = 14.478*cm; // tank height from cross section
+    G4double chamberLength = 121.92*cm; // length of tank
+    G4ThreeVector halfSize(0.5*reflectorHeight, 0.5*reflectorHeight, 0.5*chamberLength);
+
+    fLightMap.SetGrid(fLightMapXYBins, fLightMapXYBins, fLightMapZBins,
+                      -halfSize, halfSize, nbOfPMTs, fLightMapTimeBins, fLightMapTimeMax);
+  }
+  else {
+    fLightMap.SetGrid(0, 0, 0, G4ThreeVector(), G4ThreeVector(), 0, 0, 0.);
   }
 
+  G4AccumulableManager::Instance()->Reset();
+
   G4int nEvents = aRun->GetNumberOfEventToBeProcessed();
-  fEventAction->SetNoEvents(nEvents);
   G4cout << "Number of events set with: " << nEvents << G4endl;
-  fEventAction->SetOutputFiles(fOutputs);
   G4cout << "Output files set with " << fOutputs << G4endl;
+
+  // The master thread has no event action
+  if (!fEventAction) return;
+
+  fEventAction->SetNoEvents(nEvents);
+  fStepAction->ResetNoSteps();
+  fEventAction->SetOutputFiles(fOutputs);
+  fEventAction->SetPhotonNtuple(fPhotonNtuple);
+  fEventAction->SetHistograms(fSourcesH1, fHitsH2, fTimeSumH2, fTimesH2);
+  fEventAction->SetPathSummary(fPathSummary);
+  fEventAction->SetBiased(IsBiased());
+  fEventAction->SetDirectionBias(
+    (fDirectionBias.GetMode() != PIIDirectionBias::kNone) ? &fDirectionBias : nullptr);
+  fStepAction->SetBiasing(fRouletteBounces, fRouletteLength, fSurvival, fSplitting);
+  fEventAction->SetUniverses(fUniverses.empty() ? nullptr : &fUniverseHits);
+  fEventAction->SetBombs((fBombNtuple >= 0) ? &fBombs : nullptr);
+  if (fBombNtuple >= 0) {
+    CheckBombs();
+    PrepareBombs(nEvents);
+  }
+  if (fOutputs >= 1 && fOutputs <= 3) CheckPhotonNumbers(nEvents);
+  fEventAction->SetNoPMT(nbOfPMTs);
+  if (GetGenerator()) {
+    fEventAction->ReserveCopies(GetGenerator()->GetPhotonsPerEvent(), fSplitting);
+  }
+
+  fEventAction->SetLightMap((fLightMapOutput != "") ? &fLightMap : nullptr);
+
+  // Fast mode: one read-only map shared by all workers
+  const PIILightMap* fastMap = nullptr;
+
+  if (fLightMapInput != "") {
+    fastMap = PIILightMap::LoadShared(fLightMapInput);
+
+    if (!fastMap || fastMap->GetNoPMT() != nbOfPMTs) {
+      G4ExceptionDescription msg;
+      msg << "Light map " << fLightMapInput << " cannot be used with "
+          << nbOfPMTs << " PMTs.";
+      G4Exception("PIIRunAction::BeginOfRunAction()", "PIILightMap001",
+                  FatalException, msg);
+    }
+
+    // Photons are folded into the map segment, which must sit at the origin
+    G4ThreeVector origin = fDetConstruction->GetSegmentCentre(
+                             fDetConstruction->GetSegment(G4ThreeVector()));
+    if (origin.mag() > 0.) {
+      G4ExceptionDescription msg;
+      msg << "Light map " << fLightMapInput << " needs a segment at the origin, "
+          << "an odd number of rows and columns.";
+      G4Exception("PIIRunAction::BeginOfRunAction()", "PIILightMap003",
+                  FatalException, msg);
+    }
+  }
+
+  fStackAction->SetLightMap(fastMap);
+
+  // Rows go through the writer thread, or straight to the file
+  if (fAsyncOutput && fOutputWriter->Start()) {
+    fEventAction->SetOutputWriter(fOutputWriter);
+  }
+  else {
+    fEventAction->SetOutputWriter(nullptr);
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void PIIRunAction::EndOfRunAction(const G4Run*)
+void PIIRunAction::EndOfRunAction(const G4Run* aRun)
 {
+  G4int nbOfPMTs = fPMTHits.GetNoPMT();
+
+  // Fold this thread's totals into the accumulable and merge into the master
+  if (fEventAction) {
+    const PIIEventRecord& record = fEventAction->GetEventRecord();
+    for(G4int c = 0; c < nbOfPMTs; c++){
+      fPMTHits.AddHits(c, record.runHits[c]);
+      fPMTHits.AddTimes(c, record.runTimeSum[c], record.runTimeSum2[c]);
+    }
+    fNbOfSteps += fStepAction->GetNoSteps();
+    fNbOfDetected += record.runDetected;
+    fNbOfHousing += record.runHousing;
+    fNbOfLost += record.runLost;
+    fFates.Merge(fStepAction->GetFates());
+  }
+  G4AccumulableManager::Instance()->Merge();
+
+  if (IsMaster() && fLightMapOutput != "") {
+    fLightMap.Write(fLightMapOutput);
+  }
+
+  G4VAnalysisManager* man = PIIAnalysis::Instance();
 
-  // Save data
-  G4AnalysisManager* man = G4AnalysisManager::Instance();
+  if (IsMaster()) {
+    // One Geometry row per run, written with the merged results
+    man->FillNtupleIColumn(fGeometryNtuple, 0, nbOfPMTs);
+    man->FillNtupleIColumn(fGeometryNtuple, 1, fDetConstruction->GetNoRows());
+    man->FillNtupleIColumn(fGeometryNtuple, 2, fDetConstruction->GetNoCols());
+    man->AddNtupleRow(fGeometryNtuple);
+
+    G4cout << ">>> Run " << fRunNum << " finished" << G4endl;
+
+    // Hits and fates are sums of weights, print them as whole counts unless
+    // tracking is biased
+    G4int precision = G4cout.precision(12);
+
+    for(G4int counter = 0; counter < nbOfPMTs; counter ++){
+      G4cout << "    "
+             << fPMTHits.GetHits(counter) << " hits stored in PMT " << (counter + 1)
+             << ", time " << G4BestUnit(fPMTHits.GetMeanTime(counter), "Time")
+             << " rms " << G4BestUnit(fPMTHits.GetRmsTime(counter), "Time") << G4endl;
+    }
+
+    G4cout << "Photons detected: " << fNbOfDetected.GetValue()
+           << ", killed in housing: " << fNbOfHousing.GetValue()
+           << ", lost: " << fNbOfLost.GetValue() << G4endl;
+    G4cout.precision(precision);
+
+    fFates.Print();
+
+    if (fUniverseNtuple >= 0) WriteUniverses(man);
+    if (fBombNtuple >= 0) WriteBombs(man);
+
+    G4cout << "Number of events: " << aRun->GetNumberOfEvent() << G4endl;
+  }
+
+  // Fill the rows spilled by the writer thread, on this thread
+  if (fOutputWriter->IsRunning()) {
+    fOutputWriter->Stop(man);
+
+    if (fOutputWriter->GetNoStalls() > 0) {
+      G4cout << "Output writer: event loop waited " << fOutputWriter->GetNoStalls()
+             << " times for a full queue" << G4endl;
+    }
+  }
+
+  // Save data. The manager goes with its ntuples and histograms, the next
+  // run books them again for its own geometry and settings.
   man->Write();
   man->CloseFile();
+  PIIAnalysis::DeleteInstance();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::CreatePhotonNtuple(G4VAnalysisManager* man)
+{
+  fPhotonNtuple = man->CreateNtuple("PII_photons_" + filename + fRunid, "Photon Tracking");
+  man->CreateNtupleIColumn("PMT Hit");
+  man->CreateNtupleIColumn("Event Number");
+  man->CreateNtupleDColumn("X position");
+  man->CreateNtupleDColumn("Y position");
+  man->CreateNtupleDColumn("Z position");
+  man->CreateNtupleDColumn("X direction");
+  man->CreateNtupleDColumn("Y direction");
+  man->CreateNtupleDColumn("Z direction");
+  man->CreateNtupleDColumn("Time");
+  if (IsBiased()) man->CreateNtupleDColumn("Weight");
+  if (fPathSummary) CreatePathSummaryColumns(man);
+  man->FinishNtuple();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::CreateBombNtuple(G4VAnalysisManager* man)
+{
+  fBombNtuple = man->CreateNtuple("PII_bombs_" + filename + fRunid, "Bomb Tracking");
+  man->CreateNtupleIColumn("Event Number");
+
+  // Weighted hits are not whole numbers
+  if (IsBiased()) {
+    man->CreateNtupleDColumn("Left PMT");
+    man->CreateNtupleDColumn("Right PMT");
+  }
+  else {
+    man->CreateNtupleIColumn("Left PMT");
+    man->CreateNtupleIColumn("Right PMT");
+  }
+  man->CreateNtupleDColumn("X position");
+  man->CreateNtupleDColumn("Y position");
+  man->CreateNtupleDColumn("Z position");
+  man->FinishNtuple();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::CreatePathSummaryColumns(G4VAnalysisManager* man)
+{
+  // Path length in ScintMat and reflections off each reflective skin,
+  // the inputs of PII_reweight
+  man->CreateNtupleDColumn("Scint path");
+  man->CreateNtupleDColumn("Reflector bounces");
+  man->CreateNtupleDColumn("Light guide bounces");
+  man->CreateNtupleDColumn("Tab bounces");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::WriteUniverses(G4VAnalysisManager* man)
+{
+  G4int nbOfPMTs = fUniverseHits.GetNoPMT();
+  G4double photons = fUniverseHits.GetNoPhotons();
+  G4double nominal = fNbOfDetected.GetValue();
+
+  G4cout << "----------------------- Universes -----------------------" << G4endl;
+  G4cout << std::setw(18) << "Universe" << std::setw(14) << "Efficiency"
+         << std::setw(14) << "Error" << std::setw(12) << "Ratio" << G4endl;
+  G4cout << std::setw(18) << "nominal" << std::setw(14)
+         << (photons > 0. ? nominal/photons : 0.) << std::setw(14)
+         << (photons > 0. ? std::sqrt(nominal)/photons : 0.) << std::setw(12) << 1.
+         << G4endl;
+
+  for (G4int c = 0; c < nbOfPMTs; c++) {
+    man->FillNtupleSColumn(fUniverseNtuple, 0, "nominal");
+    man->FillNtupleIColumn(fUniverseNtuple, 1, c);
+    man->FillNtupleDColumn(fUniverseNtuple, 2, fPMTHits.GetHits(c));
+    man->FillNtupleDColumn(fUniverseNtuple, 3, photons);
+    man->AddNtupleRow(fUniverseNtuple);
+  }
+
+  for (G4int u = 0; u < fUniverseHits.GetNoUniverses(); u++) {
+    const G4String& name = fUniverses[u].name;
+    G4double detected = fUniverseHits.GetDetected(u);
+
+    G4cout << std::setw(18) << name << std::setw(14)
+           << (photons > 0. ? detected/photons : 0.) << std::setw(14)
+           << (photons > 0. ? fUniverseHits.GetDetectedError(u)/photons : 0.)
+           << std::setw(12) << (nominal > 0. ? detected/nominal : 0.) << G4endl;
+
+    for (G4int c = 0; c < nbOfPMTs; c++) {
+      man->FillNtupleSColumn(fUniverseNtuple, 0, name);
+      man->FillNtupleIColumn(fUniverseNtuple, 1, c);
+      man->FillNtupleDColumn(fUniverseNtuple, 2, fUniverseHits.GetHits(u, c));
+      man->FillNtupleDColumn(fUniverseNtuple, 3, photons);
+      man->AddNtupleRow(fUniverseNtuple);
+    }
+  }
+
+  G4cout << "---------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::CheckBombs() const
+{
+  // Bombs are merged by number, but without per-event seeds each thread
+  // keeps its own bomb position, so a bomb spread over events of several
+  // threads mixes positions. Warn once, from the first worker.
+  if (!G4Threading::IsMultithreadedApplication() || G4Threading::G4GetThreadId() != 0) return;
+
+  PIIPrimaryGeneratorAction* gen = GetGenerator();
+  if (!gen) return;
+
+  if (gen->GetDistribution() != 3 || gen->GetPerEventSeeds()) return;
+  if (gen->GetPhotonsPerEvent() % gen->GetBombSize() == 0) return;
+
+  G4ExceptionDescription msg;
+  msg << "Bombs of " << gen->GetBombSize() << " photons span events of "
+      << gen->GetPhotonsPerEvent() << " photons, which may run on different"
+      << " threads without per-event seeds." << G4endl
+      << "Bomb positions are only consistent with /PII/random/perEvent true"
+      << " or a bomb size that divides the photons per event.";
+  G4Exception("PIIRunAction::BeginOfRunAction()", "PIIBomb001", JustWarning, msg);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::CheckPhotonNumbers(G4int nEvents) const
+{
+  // Photon and bomb numbers are written to integer columns, refuse a run
+  // whose last photon number would not fit rather than let it wrap
+  PIIPrimaryGeneratorAction* gen = GetGenerator();
+  if (!gen) return;
+
+  G4long lastPhoton = (gen->GetEventOffset() + nEvents) * gen->GetPhotonsPerEvent();
+  if (lastPhoton <= std::numeric_limits<G4int>::max()) return;
+
+  G4ExceptionDescription msg;
+  msg << "Photon numbers of this run go up to " << lastPhoton
+      << ", beyond the integer columns of the photon and bomb ntuples." << G4endl
+      << "Split the run into shards of fewer photons, or use /PII/output/files 4.";
+  G4Exception("PIIRunAction::BeginOfRunAction()", "PIIOutput001", FatalException, msg);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::PrepareBombs(G4int nEvents)
+{
+  // Bombs from the one of the first photon of the run to the one of its
+  // last, numbered as in PIIEventAction from photon numbers starting at 1
+  PIIPrimaryGeneratorAction* gen = GetGenerator();
+  if (!gen) return;
+
+  G4int bombSize = gen->GetBombSize();
+  G4long firstPhoton = gen->GetEventOffset() * gen->GetPhotonsPerEvent();
+  G4long lastPhoton = (gen->GetEventOffset() + nEvents) * gen->GetPhotonsPerEvent();
+
+  G4long firstBomb = firstPhoton / bombSize;
+  G4long nbOfBombs = (lastPhoton > firstPhoton) ? (lastPhoton - 1) / bombSize - firstBomb + 1 : 0;
+
+  fBombs.SetBombs(firstBomb, nbOfBombs, bombSize);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIPrimaryGeneratorAction* PIIRunAction::GetGenerator() const
+{
+  // The generator of this thread, the master of a multithreaded run has none
+  return const_cast<PIIPrimaryGeneratorAction*>(
+    static_cast<const PIIPrimaryGeneratorAction*>(
+      G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction()));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::WriteBombs(G4VAnalysisManager* man)
+{
+  // Only bombs that got all their photons are written, like a single thread
+  // that closes a bomb with its last photon
+  G4int bombSize = fBombs.GetBombSize();
+  G4int incomplete = 0;
+
+  G4int written = 0;
+
+  const std::vector<PIIBomb>& bombs = fBombs.GetBombs();
+  for (size_t b = 0; b < bombs.size(); b++) {
+    const PIIBomb& bomb = bombs[b];
+    if (bomb.photons == 0) continue;
+    if (bomb.photons != bombSize) {
+      incomplete++;
+      continue;
+    }
+
+    // Numbered by the last photon of the bomb, weighted hits are doubles
+    G4long bombNo = fBombs.GetFirstBomb() + (G4long)b;
+    man->FillNtupleIColumn(fBombNtuple, 0, (G4int)((bombNo + 1) * bombSize));
+    G4int column = 1;
+    if (IsBiased()) {
+      man->FillNtupleDColumn(fBombNtuple, column++, bomb.left);
+      man->FillNtupleDColumn(fBombNtuple, column++, bomb.right);
+    }
+    else {
+      man->FillNtupleIColumn(fBombNtuple, column++, (G4int)bomb.left);
+      man->FillNtupleIColumn(fBombNtuple, column++, (G4int)bomb.right);
+    }
+    man->FillNtupleDColumn(fBombNtuple, column++, bomb.pos.x());
+    man->FillNtupleDColumn(fBombNtuple, column++, bomb.pos.y());
+    man->FillNtupleDColumn(fBombNtuple, column++, bomb.pos.z());
+    man->AddNtupleRow(fBombNtuple);
+    written++;
+  }
+
+  G4cout << "Bombs written: " << written;
+  if (incomplete > 0) G4cout << ", incomplete and skipped: " << incomplete;
+  G4cout << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -143,11 +567,40 @@ void PIIRunAction::SetRunid(G4String runid, G4int rnum)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void PIIRunAction::SetLabel(G4String label)
+{
+  fLabel = label;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void PIIRunAction::SetDefaults()
 {
   filename = "";
   fOutputs = 3;
   fRunid = "";
+  fLabel = "";
+  fRunNum = 0;
+  fCompression = 1;
+  fAsyncOutput = false;
+  fPathSummary = false;
+  fZBins = 100;
+  fTimeBins = 200;
+  fTimeMax = 200.*ns;
+  fLightMapOutput = "";
+  fLightMapInput = "";
+  fLightMapXYBins = 5;
+  fLightMapZBins = 40;
+  fLightMapTimeBins = 50;
+  fLightMapTimeMax = 100.*ns;
+  fRouletteBounces = 0;
+  fRouletteLength = 0.;
+  fSurvival = 0.5;
+  fSplitting = 1;
+  fDirectionBias.SetMode(PIIDirectionBias::kNone);
+  fDirectionBias.SetConeAngle(30.*deg);
+  fDirectionBias.SetConeFraction(0.5);
+  PIIAnalysis::SetFormat("csv");
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -156,3 +609,170 @@ void PIIRunAction::SetOutputFiles(G4int outputs)
 {
   fOutputs = outputs;
 }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetFormat(G4String format)
+{
+  PIIAnalysis::SetFormat(format);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetCompression(G4int level)
+{
+  fCompression = level;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::AddUniverse(const PIIUniverse& universe)
+{
+  fUniverses.push_back(universe);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::ClearUniverses()
+{
+  fUniverses.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetRouletteBounces(G4int bounces)
+{
+  fRouletteBounces = bounces;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetRouletteLength(G4double length)
+{
+  fRouletteLength = length;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetSurvival(G4double survival)
+{
+  fSurvival = survival;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetSplitting(G4int splitting)
+{
+  fSplitting = splitting;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetDirectionMode(G4int mode)
+{
+  fDirectionBias.SetMode(mode);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetConeAngle(G4double angle)
+{
+  // The range of the command is in its default unit, check again in any unit
+  if (angle <= 0. || angle > 180.*deg) {
+    G4Exception("PIIRunAction::SetConeAngle()", "PIIDirectionBias005",
+                JustWarning, "Cone half-angle must be in (0, 180] deg, ignored.");
+    return;
+  }
+  fDirectionBias.SetConeAngle(angle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetConeFraction(G4double fraction)
+{
+  fDirectionBias.SetConeFraction(fraction);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetDirectionMap(G4String file)
+{
+  fDirectionBias.ReadMap(file);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetPathSummary(G4bool summary)
+{
+  fPathSummary = summary;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetAsyncOutput(G4bool async)
+{
+  fAsyncOutput = async;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetZBins(G4int bins)
+{
+  fZBins = bins;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetTimeBins(G4int bins)
+{
+  fTimeBins = bins;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetTimeMax(G4double time)
+{
+  fTimeMax = time;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetLightMapOutput(G4String file)
+{
+  fLightMapOutput = file;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetLightMapInput(G4String file)
+{
+  fLightMapInput = file;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetLightMapXYBins(G4int bins)
+{
+  fLightMapXYBins = bins;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetLightMapZBins(G4int bins)
+{
+  fLightMapZBins = bins;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetLightMapTimeBins(G4int bins)
+{
+  fLightMapTimeBins = bins;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIRunAction::SetLightMapTimeMax(G4double time)
+{
+  fLightMapTimeMax = time;
+}
@@ -7,6 +7,8 @@
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcommand.hh"
 #include "G4SystemOfUnits.hh"
 
@@ -23,30 +25,111 @@ PIIRunMessenger::PIIRunMessenger(PIIRunAction* runner)
   fFilenameCmd->SetParameterName("filenames", true);
   fFilenameCmd->SetDefaultValue("");
   fFilenameCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-  fFilenameCmd->SetToBeBroadcasted(false);
 
   fRunidCmd = new G4UIcmdWithAnInteger("/PII/output/runid", this);
   fRunidCmd->SetGuidance("Set run number to append to filename.");
   fRunidCmd->SetParameterName("runid", true);
   fRunidCmd->SetDefaultValue(0);
   fRunidCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-  fRunidCmd->SetToBeBroadcasted(false);
+
+  fLabelCmd = new G4UIcmdWithAString("/PII/output/label", this);
+  fLabelCmd->SetGuidance("Set label of the output file, written as PII_<label>.");
+  fLabelCmd->SetGuidance("Set for each point of a sweep. An empty label writes PII.");
+  fLabelCmd->SetParameterName("label", true);
+  fLabelCmd->SetDefaultValue("");
+  fLabelCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 
   fOutputCmd = new G4UIcmdWithAnInteger("/PII/output/files", this);
   fOutputCmd->SetGuidance("Set which output files to create.");
   fOutputCmd->SetGuidance("1 is for only photon-level data.");
   fOutputCmd->SetGuidance("2 is for only bomb-level data.");
   fOutputCmd->SetGuidance("3 is for both files.");
+  fOutputCmd->SetGuidance("4 is for per-PMT hit and arrival time histograms binned in source z.");
+
+  fFormatCmd = new G4UIcmdWithAString("/PII/output/format", this);
+  fFormatCmd->SetGuidance("Set output file format.");
+  fFormatCmd->SetGuidance("csv writes one text file per ntuple.");
+  fFormatCmd->SetGuidance("root writes one compressed binary file, merged over threads.");
+  fFormatCmd->SetGuidance("xml is for debugging only.");
+  fFormatCmd->SetGuidance("Default value is csv. Takes effect at the next run.");
+  fFormatCmd->SetParameterName("format", true);
+  fFormatCmd->SetDefaultValue("csv");
+  fFormatCmd->SetCandidates("csv root xml");
+  fFormatCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fCompressionCmd = new G4UIcmdWithAnInteger("/PII/output/compression", this);
+  fCompressionCmd->SetGuidance("Set compression level of root output, 0 for none.");
+  fCompressionCmd->SetGuidance("Default value is 1.");
+  fCompressionCmd->SetParameterName("compression", true);
+  fCompressionCmd->SetDefaultValue(1);
+  fCompressionCmd->SetRange("compression >= 0 && compression <= 9");
+  fCompressionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fAsyncWriterCmd = new G4UIcmdWithABool("/PII/output/asyncWriter", this);
+  fAsyncWriterCmd->SetGuidance("Spool ntuple rows to a temporary file from a separate thread");
+  fAsyncWriterCmd->SetGuidance("per worker. Events queue their rows and carry on while the");
+  fAsyncWriterCmd->SetGuidance("writer catches up; the worker fills them into the ntuples at");
+  fAsyncWriterCmd->SetGuidance("the end of the run, as the analysis manager is thread-local.");
+  fAsyncWriterCmd->SetGuidance("Default value is false.");
+  fAsyncWriterCmd->SetParameterName("asyncWriter", true);
+  fAsyncWriterCmd->SetDefaultValue(true);
+  fAsyncWriterCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fPathSummaryCmd = new G4UIcmdWithABool("/PII/output/pathSummary", this);
+  fPathSummaryCmd->SetGuidance("Add the path summary of each photon to the photon ntuple:");
+  fPathSummaryCmd->SetGuidance("path length in the scintillator and reflections off the");
+  fPathSummaryCmd->SetGuidance("reflector, light guide and tab skins. PII_reweight then gives");
+  fPathSummaryCmd->SetGuidance("the efficiency for other reflectivities and attenuation lengths.");
+  fPathSummaryCmd->SetGuidance("Needs full tracking, /PII/fastsim/scintillator false.");
+  fPathSummaryCmd->SetGuidance("Default value is false.");
+  fPathSummaryCmd->SetParameterName("pathSummary", true);
+  fPathSummaryCmd->SetDefaultValue(true);
+  fPathSummaryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fZBinsCmd = new G4UIcmdWithAnInteger("/PII/output/zBins", this);
+  fZBinsCmd->SetGuidance("Set number of source z bins for output mode 4.");
+  fZBinsCmd->SetGuidance("Bins span the chamber length, 121.92 cm.");
+  fZBinsCmd->SetGuidance("Default value is 100.");
+  fZBinsCmd->SetParameterName("zBins", true);
+  fZBinsCmd->SetDefaultValue(100);
+  fZBinsCmd->SetRange("zBins >= 1");
+  fZBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fTimeBinsCmd = new G4UIcmdWithAnInteger("/PII/output/timeBins", this);
+  fTimeBinsCmd->SetGuidance("Set number of arrival time bins for output mode 4.");
+  fTimeBinsCmd->SetGuidance("Times are histogrammed per PMT plane, mean times per PMT");
+  fTimeBinsCmd->SetGuidance("come from the summed time and hit H2s.");
+  fTimeBinsCmd->SetGuidance("Default value is 200.");
+  fTimeBinsCmd->SetParameterName("timeBins", true);
+  fTimeBinsCmd->SetDefaultValue(200);
+  fTimeBinsCmd->SetRange("timeBins >= 1");
+  fTimeBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fTimeMaxCmd = new G4UIcmdWithADoubleAndUnit("/PII/output/timeMax", this);
+  fTimeMaxCmd->SetGuidance("Set upper edge of the arrival time histograms for output mode 4.");
+  fTimeMaxCmd->SetGuidance("Default value is 200 ns.");
+  fTimeMaxCmd->SetParameterName("timeMax", true);
+  fTimeMaxCmd->SetDefaultValue(200.);
+  fTimeMaxCmd->SetDefaultUnit("ns");
+  fTimeMaxCmd->SetRange("timeMax > 0.");
+  fTimeMaxCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 
   fDefaultsCmd = new G4UIcommand("/output/defaults", this);
   fDefaultsCmd->SetGuidance("Sets filename to default");
   fDefaultsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-  fDefaultsCmd->SetToBeBroadcasted(false);
 }
 
 PIIRunMessenger::~PIIRunMessenger()
 {
   delete fFilenameCmd;
+  delete fLabelCmd;
+  delete fFormatCmd;
+  delete fCompressionCmd;
+  delete fAsyncWriterCmd;
+  delete fPathSummaryCmd;
+  delete fZBinsCmd;
+  delete fTimeBinsCmd;
+  delete fTimeMaxCmd;
 }
 
 void PIIRunMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
@@ -58,9 +141,33 @@ void PIIRunMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
   else if (command == fRunidCmd) {
     fRunAction->SetRunid(newValue, fRunidCmd->GetNewIntValue(newValue));
   }
+  else if (command == fLabelCmd) {
+    fRunAction->SetLabel(newValue);
+  }
   else if (command == fOutputCmd) {
     fRunAction->SetOutputFiles(fOutputCmd->GetNewIntValue(newValue));
   }
+  else if (command == fFormatCmd) {
+    fRunAction->SetFormat(newValue);
+  }
+  else if (command == fCompressionCmd) {
+    fRunAction->SetCompression(fCompressionCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fAsyncWriterCmd) {
+    fRunAction->SetAsyncOutput(fAsyncWriterCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fPathSummaryCmd) {
+    fRunAction->SetPathSummary(fPathSummaryCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fZBinsCmd) {
+    fRunAction->SetZBins(fZBinsCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fTimeBinsCmd) {
+    fRunAction->SetTimeBins(fTimeBinsCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fTimeMaxCmd) {
+    fRunAction->SetTimeMax(fTimeMaxCmd->GetNewDoubleValue(newValue));
+  }
   else if (command == fDefaultsCmd) {
     fRunAction->SetDefaults();
   }
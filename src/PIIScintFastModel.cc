@@ -0,0 +1,374 @@
+/// \file PIIScintFastModel.cc
+/// \brief Implementation of the PIIScintFastModel class
+
+#include "PIIScintFastModel.hh"
+#include "PIIFateAccumulable.hh"
+
+#include "G4Box.hh"
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4OpticalSurface.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+std::atomic<G4bool> PIIScintFastModel::fEnabled(false);
+std::atomic<G4int>  PIIScintFastModel::fGeneration(0);
+G4ThreadLocal G4int PIIScintFastModel::fLastReflections = 0;
+G4ThreadLocal G4int PIIScintFastModel::fLastFate = -1;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIScintFastModel::PIIScintFastModel(const G4String& modelName, G4Region* envelope,
+                                     const G4OpticalSurface* reflector)
+ : G4VFastSimulationModel(modelName, envelope),
+   fReflector(reflector),
+   fHandBackDistance(1.*mm),
+   fMaxBounces(100000),
+   fCachedEnvelopeID(-1),
+   fCachedGeneration(-1)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIScintFastModel::~PIIScintFastModel()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIScintFastModel::SetEnabled(G4bool enabled)
+{
+  fEnabled = enabled;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIIScintFastModel::IsEnabled()
+{
+  return fEnabled;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIScintFastModel::NewGeometry()
+{
+  fGeneration++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PIIScintFastModel::GetLastReflections()
+{
+  return fLastReflections;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PIIScintFastModel::GetLastFate()
+{
+  return fLastFate;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIIScintFastModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+  return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIIScintFastModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+  if (!fEnabled) return false;
+
+  const G4Box* box = dynamic_cast<const G4Box*>(fastTrack.GetEnvelopeSolid());
+  if (!box) return false;
+
+  // The region reaches into the daughters of the envelope, which the model
+  // does not transport
+  const G4LogicalVolume* envelope = fastTrack.GetEnvelopeLogicalVolume();
+  if (fastTrack.GetPrimaryTrack()->GetVolume()->GetLogicalVolume() != envelope) {
+    return false;
+  }
+
+  // Photons handed back near an end face, or coming back in through one,
+  // are left to normal tracking until they reach a side wall
+  const G4ThreeVector& pos = fastTrack.GetPrimaryTrackLocalPosition();
+  if (std::fabs(pos.z()) >= box->GetZHalfLength() - 2.*fHandBackDistance) {
+    return false;
+  }
+
+  // Likewise near a tab, where they were handed back or just left it
+  if (envelope->GetInstanceID() != fCachedEnvelopeID || fGeneration != fCachedGeneration) {
+    CacheDaughters(envelope);
+  }
+  return !NearDaughter(pos, 2.*fHandBackDistance);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIScintFastModel::CacheDaughters(const G4LogicalVolume* envelope)
+{
+  fDaughters.clear();
+  fCachedEnvelopeID = envelope->GetInstanceID();
+  fCachedGeneration = fGeneration;
+
+  for (size_t i = 0; i < envelope->GetNoDaughters(); i++) {
+    const G4VPhysicalVolume* pv = envelope->GetDaughter(i);
+
+    Daughter daughter;
+    daughter.solid = pv->GetLogicalVolume()->GetSolid();
+
+    // Same transforms as the navigator, envelope to daughter and back
+    G4AffineTransform toEnvelope(pv->GetRotation(), pv->GetTranslation());
+    daughter.toLocal = toEnvelope.Inverse();
+
+    // Bounding box of the daughter in the envelope frame, from the corners
+    // of its own bounding box
+    G4ThreeVector localMin, localMax;
+    daughter.solid->BoundingLimits(localMin, localMax);
+
+    for (G4int corner = 0; corner < 8; corner++) {
+      G4ThreeVector point((corner & 1) ? localMax.x() : localMin.x(),
+                          (corner & 2) ? localMax.y() : localMin.y(),
+                          (corner & 4) ? localMax.z() : localMin.z());
+      point = toEnvelope.TransformPoint(point);
+
+      for (G4int a = 0; a < 3; a++) {
+        if (corner == 0 || point[a] < daughter.min[a]) daughter.min[a] = point[a];
+        if (corner == 0 || point[a] > daughter.max[a]) daughter.max[a] = point[a];
+      }
+    }
+
+    fDaughters.push_back(daughter);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIIScintFastModel::NearDaughter(const G4ThreeVector& pos, G4double distance) const
+{
+  for (size_t i = 0; i < fDaughters.size(); i++) {
+    const Daughter& daughter = fDaughters[i];
+
+    G4bool inBox = true;
+    for (G4int a = 0; a < 3 && inBox; a++) {
+      inBox = pos[a] > daughter.min[a] - distance && pos[a] < daughter.max[a] + distance;
+    }
+    if (!inBox) continue;
+
+    G4ThreeVector local = daughter.toLocal.TransformPoint(pos);
+    if (daughter.solid->Inside(local) != kOutside) return true;
+    if (daughter.solid->DistanceToIn(local) < distance) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PIIScintFastModel::DistanceToDaughter(const G4ThreeVector& pos,
+                                               const G4ThreeVector& dir,
+                                               G4double maxDistance) const
+{
+  G4double nearest = DBL_MAX;
+
+  for (size_t i = 0; i < fDaughters.size(); i++) {
+    const Daughter& daughter = fDaughters[i];
+
+    // The segment against the bounding box first, slab by slab
+    G4double tMin = 0.;
+    G4double tMax = std::min(maxDistance, nearest);
+
+    for (G4int a = 0; a < 3 && tMin <= tMax; a++) {
+      if (dir[a] == 0.) {
+        if (pos[a] < daughter.min[a] || pos[a] > daughter.max[a]) tMax = -1.;
+        continue;
+      }
+      G4double t1 = (daughter.min[a] - pos[a]) / dir[a];
+      G4double t2 = (daughter.max[a] - pos[a]) / dir[a];
+      tMin = std::max(tMin, std::min(t1, t2));
+      tMax = std::min(tMax, std::max(t1, t2));
+    }
+    if (tMin > tMax) continue;
+
+    G4double distance
+      = daughter.solid->DistanceToIn(daughter.toLocal.TransformPoint(pos),
+                                     daughter.toLocal.TransformAxis(dir));
+    if (distance < nearest) nearest = distance;
+  }
+
+  return nearest;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIScintFastModel::HandBack(const G4Track* track, const G4ThreeVector& pos,
+                                 const G4ThreeVector& dir, G4ThreeVector polar,
+                                 G4double path, G4double groupVel,
+                                 G4FastStep& fastStep) const
+{
+  polar = polar - polar.dot(dir) * dir;
+  if (polar.mag2() <= 0.) polar = dir.orthogonal();
+
+  fastStep.ProposePrimaryTrackFinalPosition(pos);
+  fastStep.ProposePrimaryTrackFinalMomentumDirection(dir);
+  fastStep.ProposePrimaryTrackFinalPolarization(polar.unit());
+  fastStep.ProposePrimaryTrackFinalTime(track->GetGlobalTime() + path / groupVel);
+  fastStep.ProposePrimaryTrackPathLength(path);
+  fastStep.ProposeTotalEnergyDeposited(0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PIIScintFastModel::GetReflectorProperty(const char* name, G4double energy,
+                                                 G4double defaultValue) const
+{
+  if (!fReflector) return defaultValue;
+
+  G4MaterialPropertiesTable* mpt = fReflector->GetMaterialPropertiesTable();
+  if (!mpt) return defaultValue;
+
+  G4MaterialPropertyVector* property = mpt->GetProperty(name);
+  if (!property) return defaultValue;
+
+  return property->Value(energy);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIScintFastModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+  const G4Track* track = fastTrack.GetPrimaryTrack();
+  const G4Box* box = static_cast<const G4Box*>(fastTrack.GetEnvelopeSolid());
+
+  G4double energy = track->GetKineticEnergy();
+
+  // Bulk properties of the scintillator. Photons travel at the group
+  // velocity, as in normal tracking, which Geant4 derives from RINDEX.
+  G4double groupVel = c_light;
+  G4double absLength = DBL_MAX;
+
+  G4MaterialPropertiesTable* mpt = track->GetMaterial()->GetMaterialPropertiesTable();
+  if (mpt) {
+    G4MaterialPropertyVector* groupVelVector = mpt->GetProperty("GROUPVEL");
+    G4MaterialPropertyVector* rindexVector = mpt->GetProperty("RINDEX");
+    G4MaterialPropertyVector* absVector = mpt->GetProperty("ABSLENGTH");
+    if (groupVelVector) groupVel = groupVelVector->Value(energy);
+    else if (rindexVector) groupVel = c_light / rindexVector->Value(energy);
+    if (absVector) absLength = absVector->Value(energy);
+  }
+
+  // Reflector, the unified model fractions that are not spike, lobe or
+  // backscatter are Lambertian
+  G4double reflectivity = GetReflectorProperty("REFLECTIVITY", energy, 1.);
+  G4double specular = GetReflectorProperty("SPECULARSPIKECONSTANT", energy, 0.)
+                    + GetReflectorProperty("SPECULARLOBECONSTANT", energy, 0.);
+  G4double backscatter = GetReflectorProperty("BACKSCATTERCONSTANT", energy, 0.);
+
+  G4double halfLength[3] = { box->GetXHalfLength(),
+                             box->GetYHalfLength(),
+                             box->GetZHalfLength() - fHandBackDistance };
+
+  G4ThreeVector pos = fastTrack.GetPrimaryTrackLocalPosition();
+  G4ThreeVector dir = fastTrack.GetPrimaryTrackLocalDirection();
+  G4ThreeVector polar = fastTrack.GetPrimaryTrackLocalPolarization();
+
+  fLastReflections = 0;
+  fLastFate = -1;
+
+  G4double absDistance = -absLength * std::log(1. - G4UniformRand());
+  G4double path = 0.;
+
+  for (G4int bounce = 0; bounce <= fMaxBounces; bounce++) {
+
+    // Nearest plane along the direction: a side wall or a hand-back plane
+    G4double step = DBL_MAX;
+    G4int axis = -1;
+
+    for (G4int a = 0; a < 3; a++) {
+      if (dir[a] == 0.) continue;
+
+      G4double limit = (dir[a] > 0.) ? halfLength[a] : -halfLength[a];
+      G4double distance = std::max((limit - pos[a]) / dir[a], 0.);
+
+      if (distance < step) {
+        step = distance;
+        axis = a;
+      }
+    }
+
+    // A tab on the way, whose ground skin is left to normal tracking
+    G4double tabDistance = DistanceToDaughter(pos, dir, step);
+    G4bool tab = tabDistance < step;
+    if (tab) step = std::max(tabDistance - fHandBackDistance, 0.);
+
+    // Absorbed in the bulk before getting there
+    if (axis < 0 || path + step >= absDistance) {
+      fLastFate = PIIFateAccumulable::kBulkAbsorbed;
+      fastStep.ProposePrimaryTrackPathLength(absDistance);
+      fastStep.KillPrimaryTrack();
+      return;
+    }
+
+    pos += step * dir;
+    path += step;
+
+    // Hand back to normal tracking just before a tab or the end face
+    if (tab || axis == 2) {
+      HandBack(track, pos, dir, polar, path, groupVel, fastStep);
+      return;
+    }
+
+    // Side wall
+    if (G4UniformRand() >= reflectivity) {
+      fLastFate = PIIFateAccumulable::kSurfaceAbsorbed;
+      fastStep.ProposePrimaryTrackPathLength(path);
+      fastStep.KillPrimaryTrack();
+      return;
+    }
+
+    fLastReflections++;
+    G4double u = G4UniformRand();
+
+    if (u < specular) {
+      dir[axis] = -dir[axis];
+      polar[axis] = -polar[axis];
+    }
+    else if (u < specular + backscatter) {
+      dir = -dir;
+    }
+    else {
+      G4ThreeVector normal;
+      normal[axis] = (dir[axis] > 0.) ? -1. : 1.;
+
+      G4ThreeVector tangent1 = normal.orthogonal().unit();
+      G4ThreeVector tangent2 = normal.cross(tangent1);
+
+      G4double cosTheta = std::sqrt(G4UniformRand());
+      G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+      G4double phi = twopi * G4UniformRand();
+
+      dir = cosTheta * normal
+          + sinTheta * (std::cos(phi) * tangent1 + std::sin(phi) * tangent2);
+    }
+  }
+
+  // Trapped between the side walls, where the bulk would absorb it in the end
+  fLastFate = PIIFateAccumulable::kBulkAbsorbed;
+  fastStep.ProposePrimaryTrackPathLength(path);
+  fastStep.KillPrimaryTrack();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
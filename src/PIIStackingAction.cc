@@ -0,0 +1,78 @@
+/// \file PIIStackingAction.cc
+/// \brief Implementation of the PIIStackingAction class
+
+#include "PIIStackingAction.hh"
+#include "PIIDetectorConstruction.hh"
+#include "PIIEventAction.hh"
+#include "PIILightMap.hh"
+
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIStackingAction::PIIStackingAction(PIIDetectorConstruction* detConstruction,
+                                     PIIEventAction* eventAction)
+ : G4UserStackingAction(), fDetConstruction(detConstruction),
+   fEventAction(eventAction), fLightMap(nullptr)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIStackingAction::~PIIStackingAction()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack PIIStackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  // Photons split by the stepping action get their track ID here
+  if (track->GetParentID() > 0) {
+    fEventAction->AssignPhotonCopy(track, track->GetTrackID());
+  }
+
+  if (!fLightMap) return fUrgent;
+
+  if (track->GetDefinition() != G4OpticalPhoton::OpticalPhotonDefinition()) {
+    return fUrgent;
+  }
+
+  // Photons without a hit keep the default "lost" flag of the event action
+  if (track->GetParentID() == 0) {
+    G4int segment = fDetConstruction->GetSegment(track->GetPosition());
+    G4ThreeVector local
+      = track->GetPosition() - fDetConstruction->GetSegmentCentre(segment);
+
+    G4double time = 0.;
+    G4int PMTno = fLightMap->SampleHit(local, time);
+    if (PMTno >= 0) PMTno = ShiftPMT(PMTno, segment);
+
+    if (PMTno >= 0) {
+      fEventAction->SetPhotonHit(track->GetTrackID(), PMTno,
+                                 track->GetGlobalTime() + time);
+    }
+  }
+
+  return fKill;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PIIStackingAction::ShiftPMT(G4int PMTno, G4int segment) const
+{
+  // PMT of the map segment, left or right, moved from the segment at the
+  // origin to the given one; -1 when that falls off the array
+  G4int nbOfCols = fDetConstruction->GetNoCols();
+  G4int nbOfScints = fDetConstruction->GetNoPMT()/2;
+  G4int origin = fDetConstruction->GetSegment(G4ThreeVector());
+
+  G4int plane = PMTno / nbOfScints;
+  G4int row = (PMTno % nbOfScints) / nbOfCols + segment / nbOfCols - origin / nbOfCols;
+  G4int col = (PMTno % nbOfScints) % nbOfCols + segment % nbOfCols - origin % nbOfCols;
+
+  if (row < 0 || row >= fDetConstruction->GetNoRows() || col < 0 || col >= nbOfCols) return -1;
+
+  return plane * nbOfScints + row * nbOfCols + col;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
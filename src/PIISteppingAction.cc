@@ -4,10 +4,24 @@
 #include "PIISteppingAction.hh"
 #include "PIIEventAction.hh"
 #include "PIIDetectorConstruction.hh"
+#include "PIIScintFastModel.hh"
 
 #include "G4Step.hh"
+#include "G4LogicalVolume.hh"
+#include "G4OpBoundaryProcess.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
 #include "G4Event.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
 #include "G4RunManager.hh"
+#include "G4SteppingManager.hh"
+#include "G4DynamicParticle.hh"
+#include "Randomize.hh"
+
+#include <cmath>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -15,7 +29,11 @@ PIISteppingAction::PIISteppingAction(
                       const PIIDetectorConstruction* detectorConstruction,
                       PIIEventAction* eventAction)
   : G4UserSteppingAction(),
-    fDetConstruction(detectorConstruction), fEventAction(eventAction)
+    fDetConstruction(detectorConstruction), fEventAction(eventAction),
+    fNbOfSteps(0), fFates("Fates"), fBoundary(nullptr), fBounces(0),
+    fScintAbsLength(nullptr), fOilAbsLength(nullptr),
+    fRouletteBounces(0), fRouletteLength(0.), fSurvival(0.5), fSplitting(1),
+    fNextBounces(0), fNextLength(0.), fSplit(false)
 {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -27,38 +45,255 @@ PIISteppingAction::~PIISteppingAction()
 
 void PIISteppingAction::UserSteppingAction(const G4Step* step)
 {
-// Collect energy and track length step by step
+  fNbOfSteps++;
 
-  // get volume of the current step
-  auto volume1 = step->GetPreStepPoint()->GetTouchableHandle()->GetVolume();
-  G4int copyNo = step->GetPreStepPoint()->GetTouchableHandle()->GetCopyNumber();
-  G4double hit_time = step->GetPreStepPoint()->GetGlobalTime();
+// Classify the step by the role of the pre-step volume
 
-  G4String name1 = volume1->GetName();
+  const G4StepPoint* preStep = step->GetPreStepPoint();
+  const G4StepPoint* postStep = step->GetPostStepPoint();
 
-  //G4cout << "VOLUME IS: " << volume2 << G4endl;
+  PIIVolumeRole role = fDetConstruction->GetVolumeRole(
+                         preStep->GetTouchableHandle()->GetVolume()->GetLogicalVolume());
 
-  // energy deposit
+  fFates.AddStep(role);
 
   // getting Track
   G4Track* theTrack = step->GetTrack();
 
-  if (name1 == "pmtCathode") {
-    fEventAction->AddPhotonHit(copyNo);
-    fEventAction->SetCurrentPMTHit(copyNo);
-    fEventAction->SetPhotonFlag(1);
-    theTrack->SetTrackStatus(fStopAndKill);
-    fEventAction->SetEventTime(hit_time);
-    //G4cout << "PMT " << copyNo << " got hit at time: " << hit_time << G4endl;
+  G4int trackID = theTrack->GetTrackID();
+
+  // Path summary of the photon, for reweighting to other ABSLENGTHs
+  if (role == kScintillatorVolume) {
+    fEventAction->AddScintPath(trackID, step->GetStepLength());
+  }
+
+  // Optical depths, for the weights of the universes
+  if (fEventAction->HasUniverses()) {
+    const G4Material* material = preStep->GetMaterial();
+    const G4Material* scintMat = fDetConstruction->GetScintMaterial();
+    const G4Material* oil = fDetConstruction->GetOilMaterial();
+
+    if (material == scintMat || material == oil) {
+      // Materials are built once, so their tables can be kept
+      if (!fScintAbsLength) {
+        fScintAbsLength = scintMat->GetMaterialPropertiesTable()->GetProperty("ABSLENGTH");
+        fOilAbsLength = oil->GetMaterialPropertiesTable()->GetProperty("ABSLENGTH");
+      }
+
+      G4bool inScint = (material == scintMat);
+      G4MaterialPropertyVector* absLength = inScint ? fScintAbsLength : fOilAbsLength;
+      G4double depth
+        = step->GetStepLength() / absLength->Value(theTrack->GetKineticEnergy());
+      fEventAction->AddDepth(trackID, inScint, depth);
+    }
   }
-  else if (name1 == "pmtHousing") {
+
+  // Cathode hits are recorded and the photon stopped by PIITrackerSD
+  if (role == kHousingVolume) {
     theTrack->SetTrackStatus(fStopAndKill);
-    fEventAction->SetPhotonFlag(-1);
+    fEventAction->SetPhotonFlag(trackID, -1);
+  }
+  else if (role != kCathodeVolume) {
+    fEventAction->SetPhotonFlag(trackID, -2);
+  }
+
+  // Surface interactions, charged to the volume on the far side of the
+  // boundary, which is the one carrying the reflector and tab skins
+
+  G4VPhysicalVolume* postVolume = postStep->GetPhysicalVolume();
+  G4OpBoundaryProcessStatus boundaryStatus = Undefined;
+
+  if (postVolume && postStep->GetStepStatus() == fGeomBoundary
+      && theTrack->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition()) {
+
+    if (!fBoundary) {
+      G4ProcessVector* processes
+        = theTrack->GetDefinition()->GetProcessManager()->GetProcessList();
+      for (G4int i = 0; i < processes->entries(); i++) {
+        if ((*processes)[i]->GetProcessSubType() == fOpBoundary) {
+          fBoundary = static_cast<G4OpBoundaryProcess*>((*processes)[i]);
+          break;
+        }
+      }
+    }
+
+    if (fBoundary) {
+      boundaryStatus = fBoundary->GetStatus();
+      PIIVolumeRole surfaceRole
+        = fDetConstruction->GetVolumeRole(postVolume->GetLogicalVolume());
+
+      switch (boundaryStatus) {
+        case FresnelReflection:
+        case TotalInternalReflection:
+          fFates.AddReflection(surfaceRole);
+          fBounces++;
+          break;
+        // Reflections off the REFLECTIVITY of a dielectric_metal skin
+        case LambertianReflection:
+        case LobeReflection:
+        case SpikeReflection:
+        case BackScattering:
+          fFates.AddReflection(surfaceRole);
+          fEventAction->AddBounce(trackID, surfaceRole);
+          fBounces++;
+          break;
+        case Absorption:
+          fFates.AddSurfaceAbsorption(surfaceRole);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  // Steps of the fast scintillator model, whose wall reflections are those
+  // of the reflector lining the segment
+  const G4VProcess* process = postStep->GetProcessDefinedStep();
+  G4bool fastSim = process && process->GetProcessType() == fParameterisation;
+
+  if (fastSim) {
+    G4int reflections = PIIScintFastModel::GetLastReflections();
+    for (G4int i = 0; i < reflections; i++) fFates.AddReflection(kReflectorVolume);
+    fBounces += reflections;
+  }
+
+  // Russian roulette and splitting of the photons still alive
+
+  G4bool rouletted = false;
+  if (theTrack->GetTrackStatus() == fAlive
+      && (fRouletteBounces > 0 || fRouletteLength > 0. || fSplitting > 1)) {
+    rouletted = ApplyBiasing(step);
+  }
+
+  // Fate of the track once it ends
+
+  if (theTrack->GetTrackStatus() == fAlive) return;
+
+  G4int fate;
+
+  if (rouletted) {
+    fate = PIIFateAccumulable::kRouletted;
+  }
+  else if (role == kCathodeVolume) {
+    fate = PIIFateAccumulable::kDetected;
+  }
+  else if (role == kHousingVolume) {
+    fate = PIIFateAccumulable::kHousing;
+  }
+  else if (!postVolume) {
+    fate = PIIFateAccumulable::kEscaped;
+  }
+  else if (process && process->GetProcessSubType() == fOpAbsorption) {
+    fate = PIIFateAccumulable::kBulkAbsorbed;
+    fFates.AddBulkAbsorption(role);
+  }
+  else if (boundaryStatus == Absorption) {
+    fate = PIIFateAccumulable::kSurfaceAbsorbed;
   }
-  else if (name1 != "pmtCathode" && name1 != "pmtHousing"){
-    fEventAction->SetPhotonFlag(-2);
+  // Absorbed inside the fast model, in the bulk or on the reflector
+  else if (fastSim && PIIScintFastModel::GetLastFate() >= 0) {
+    fate = PIIScintFastModel::GetLastFate();
+    if (fate == PIIFateAccumulable::kBulkAbsorbed) fFates.AddBulkAbsorption(role);
+    else fFates.AddSurfaceAbsorption(kReflectorVolume);
+  }
+  else {
+    fate = PIIFateAccumulable::kOtherFate;
+  }
+
+  // A rouletted photon hands its weight to the survivors, it ends with none
+  // so that the lost photons are not counted twice
+  fEventAction->SetPhotonWeight(trackID, rouletted ? 0. : theTrack->GetWeight());
+
+  fFates.AddFate(fate, fBounces);
+  fBounces = 0;
+  fNextBounces = fRouletteBounces;
+  fNextLength = fRouletteLength;
+  fSplit = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIISteppingAction::SetBiasing(G4int rouletteBounces, G4double rouletteLength,
+                                   G4double survival, G4int splitting)
+{
+  fRouletteBounces = rouletteBounces;
+  fRouletteLength = rouletteLength;
+  fSurvival = survival;
+  fSplitting = splitting;
+  fNextBounces = fRouletteBounces;
+  fNextLength = fRouletteLength;
+  fSplit = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIISteppingAction::ApplyBiasing(const G4Step* step)
+{
+  G4Track* track = step->GetTrack();
+  G4int trackID = track->GetTrackID();
+
+  // Photons that have bounced or travelled far have little chance left to
+  // reach a PMT: they survive a roulette with probability fSurvival and
+  // carry the weight of those that did not
+  G4bool roulette = false;
+
+  if (fRouletteBounces > 0 && fBounces >= fNextBounces) {
+    roulette = true;
+    fNextBounces = fBounces + fRouletteBounces;
+  }
+
+  G4double length = track->GetTrackLength();
+  if (fRouletteLength > 0. && length >= fNextLength) {
+    roulette = true;
+    fNextLength = (std::floor(length/fRouletteLength) + 1.)*fRouletteLength;
+  }
+
+  if (roulette) {
+    if (G4UniformRand() >= fSurvival) {
+      track->SetTrackStatus(fStopAndKill);
+      return true;
+    }
+    track->SetWeight(track->GetWeight()/fSurvival);
+  }
+
+  // Primary photons leaving the tank through an end window, towards a light
+  // guide and PMT, go on as fSplitting copies that share their weight. The
+  // copies are secondaries of this step and are never split again.
+  // The split is made where the step crosses the outer face of an end
+  // window, |z| = GetMountPlaneZ(), rather than on entry into the light
+  // guide: the guide is a reflective shell around the path of the photons,
+  // which reach the PMT through its opening without ever stepping into it.
+  if (fSplitting < 2 || fSplit || !fEventAction->IsPrimaryPhoton(trackID)) {
+    return false;
+  }
+
+  G4double mountZ = fDetConstruction->GetMountPlaneZ();
+  const G4StepPoint* postStep = step->GetPostStepPoint();
+
+  if (std::abs(step->GetPreStepPoint()->GetPosition().z()) >= mountZ
+      || std::abs(postStep->GetPosition().z()) < mountZ) {
+    return false;
+  }
+
+  fSplit = true;
+
+  G4double weight = track->GetWeight()/fSplitting;
+  track->SetWeight(weight);
+
+  G4TrackVector* secondaries = fpSteppingManager->GetfSecondary();
+
+  for (G4int n = 1; n < fSplitting; n++) {
+    G4Track* copy = new G4Track(new G4DynamicParticle(*track->GetDynamicParticle()),
+                                postStep->GetGlobalTime(), postStep->GetPosition());
+    copy->SetTouchableHandle(postStep->GetTouchableHandle());
+    copy->SetParentID(trackID);
+    copy->SetWeight(weight);
+    secondaries->push_back(copy);
+
+    fEventAction->AddPhotonCopy(trackID, copy);
   }
 
+  return false;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,159 @@
+/// \file PIISweep.cc
+/// \brief Implementation of the PIISweep class
+
+#include "PIISweep.hh"
+#include "PIISweepMessenger.hh"
+
+#include "G4UImanager.hh"
+#include "G4UIcommandStatus.hh"
+#include "G4UIcommand.hh"
+#include "G4ios.hh"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIISweep::PIISweep()
+ : fSweepMessenger(0), fNbOfEvents(1000)
+{
+  fSweepMessenger = new PIISweepMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIISweep::~PIISweep()
+{
+  delete fSweepMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIISweep::Parse(const G4String& fileName, std::vector<G4String>& common,
+                       std::vector<Point>& points) const
+{
+  std::ifstream in(fileName);
+  if (!in) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open sweep file " << fileName;
+    G4Exception("PIISweep::Parse()", "PIISweep001", JustWarning, msg);
+    return false;
+  }
+
+  G4int events = fNbOfEvents;
+  std::string line;
+
+  for (G4int lineNo = 1; std::getline(in, line); lineNo++) {
+    // Comments run to the end of the line
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line.erase(hash);
+
+    std::istringstream fields(line);
+    std::string keyword;
+    if (!(fields >> keyword)) continue;
+
+    if (keyword[0] == '/') {
+      // Commands keep their parameters as written, trailing blanks removed
+      G4String command = line.substr(line.find('/'));
+      command = command.substr(0, command.find_last_not_of(" \t\r") + 1);
+      if (points.empty()) common.push_back(command);
+      else points.back().commands.push_back(command);
+      continue;
+    }
+
+    std::string value;
+    if ((keyword == "point" || keyword == "events") && fields >> value) {
+      if (keyword == "point") {
+        Point point;
+        point.label = value;
+        point.events = events;
+        points.push_back(point);
+      }
+      else if (points.empty()) {
+        events = G4UIcommand::ConvertToInt(value.c_str());
+      }
+      else {
+        points.back().events = G4UIcommand::ConvertToInt(value.c_str());
+      }
+      continue;
+    }
+
+    G4ExceptionDescription msg;
+    msg << fileName << ", line " << lineNo << ": cannot read \"" << line << "\"";
+    G4Exception("PIISweep::Parse()", "PIISweep002", JustWarning, msg);
+    return false;
+  }
+
+  if (points.empty()) {
+    G4ExceptionDescription msg;
+    msg << "Sweep file " << fileName << " has no points";
+    G4Exception("PIISweep::Parse()", "PIISweep003", JustWarning, msg);
+    return false;
+  }
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PIISweep::Apply(const G4String& command)
+{
+  G4String path = command.substr(0, command.find_first_of(" \t"));
+
+  // Unchanged settings are not applied again, so nothing gets rebuilt
+  std::map<G4String, G4String>::const_iterator applied = fApplied.find(path);
+  if (applied != fApplied.end() && applied->second == command) return true;
+
+  G4int status = G4UImanager::GetUIpointer()->ApplyCommand(command);
+  if (status != fCommandSucceeded) {
+    G4ExceptionDescription msg;
+    msg << "Sweep command \"" << command << "\" failed with status " << status
+        << ", sweep stopped";
+    G4Exception("PIISweep::Apply()", "PIISweep004", JustWarning, msg);
+    return false;
+  }
+
+  fApplied[path] = command;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIISweep::Run(const G4String& fileName)
+{
+  std::vector<G4String> common;
+  std::vector<Point> points;
+  if (!Parse(fileName, common, points)) return;
+
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  fApplied.clear();
+
+  G4bool ok = true;
+  for (size_t c = 0; ok && c < common.size(); c++) ok = Apply(common[c]);
+
+  for (size_t p = 0; ok && p < points.size(); p++) {
+    const Point& point = points[p];
+
+    G4cout << "===== Sweep point " << p + 1 << "/" << points.size() << ": "
+           << point.label << ", " << point.events << " events =====" << G4endl;
+
+    for (size_t c = 0; ok && c < point.commands.size(); c++) {
+      ok = Apply(point.commands[c]);
+    }
+    if (!ok) break;
+
+    auto start = std::chrono::steady_clock::now();
+    UImanager->ApplyCommand("/PII/output/label " + point.label);
+    UImanager->ApplyCommand("/run/beamOn " + std::to_string(point.events));
+    auto end = std::chrono::steady_clock::now();
+
+    G4cout << "===== Sweep point " << point.label << " done in "
+           << std::chrono::duration<G4double>(end - start).count() << " s =====" << G4endl;
+  }
+
+  // Later runs write the unlabelled output again
+  UImanager->ApplyCommand("/PII/output/label");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
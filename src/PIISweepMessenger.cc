@@ -0,0 +1,58 @@
+/// \file PIISweepMessenger.cc
+/// \brief Implementation of the PIISweepMessenger class
+
+#include "PIISweepMessenger.hh"
+#include "PIISweep.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIISweepMessenger::PIISweepMessenger(PIISweep* sweep)
+ : fSweep(sweep)
+{
+  fSweepDirectory = new G4UIdirectory("/PII/sweep/");
+  fSweepDirectory->SetGuidance("In-process parameter sweep commands.");
+
+  fRunCmd = new G4UIcmdWithAString("/PII/sweep/run", this);
+  fRunCmd->SetGuidance("Run every parameter point of the given sweep file.");
+  fRunCmd->SetGuidance("Each point is one run, written with its label as output label.");
+  fRunCmd->SetGuidance("Commands are only applied when their value changes.");
+  fRunCmd->SetParameterName("file", false);
+  fRunCmd->AvailableForStates(G4State_Idle);
+  fRunCmd->SetToBeBroadcasted(false);
+
+  fEventsCmd = new G4UIcmdWithAnInteger("/PII/sweep/events", this);
+  fEventsCmd->SetGuidance("Set number of events per point, unless the sweep file sets it.");
+  fEventsCmd->SetGuidance("Default value is 1000.");
+  fEventsCmd->SetParameterName("events", true);
+  fEventsCmd->SetDefaultValue(1000);
+  fEventsCmd->SetRange("events >= 0");
+  fEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEventsCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIISweepMessenger::~PIISweepMessenger()
+{
+  delete fRunCmd;
+  delete fEventsCmd;
+  delete fSweepDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIISweepMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fRunCmd) {
+    fSweep->Run(newValue);
+  }
+  else if (command == fEventsCmd) {
+    fSweep->SetNoEvents(fEventsCmd->GetNewIntValue(newValue));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
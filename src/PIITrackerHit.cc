@@ -18,8 +18,9 @@ PIITrackerHit::PIITrackerHit()
  : G4VHit(),
    fTrackID(-1),
    fPMTNb(-1),
-   fEdep(0.),
-   fPos(G4ThreeVector())
+   fTime(0.),
+   fPos(G4ThreeVector()),
+   fWavelength(0.)
 {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -31,20 +32,22 @@ PIITrackerHit::~PIITrackerHit() {}
 PIITrackerHit::PIITrackerHit(const PIITrackerHit& right)
   : G4VHit()
 {
-  fTrackID   = right.fTrackID;
-  fPMTNb     = right.fPMTNb;
-  fEdep      = right.fEdep;
-  fPos       = right.fPos;
+  fTrackID    = right.fTrackID;
+  fPMTNb      = right.fPMTNb;
+  fTime       = right.fTime;
+  fPos        = right.fPos;
+  fWavelength = right.fWavelength;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 const PIITrackerHit& PIITrackerHit::operator=(const PIITrackerHit& right)
 {
-  fTrackID   = right.fTrackID;
-  fPMTNb     = right.fPMTNb;
-  fEdep      = right.fEdep;
-  fPos       = right.fPos;
+  fTrackID    = right.fTrackID;
+  fPMTNb      = right.fPMTNb;
+  fTime       = right.fTime;
+  fPos        = right.fPos;
+  fWavelength = right.fWavelength;
 
   return *this;
 }
@@ -79,10 +82,12 @@ void PIITrackerHit::Print()
 {
   G4cout
      << "  trackID: " << fTrackID << " PMT Nb: " << fPMTNb
-     << "Edep: "
-     << std::setw(7) << G4BestUnit(fEdep,"Energy")
+     << " Time: "
+     << std::setw(7) << G4BestUnit(fTime,"Time")
      << " Position: "
      << std::setw(7) << G4BestUnit(fPos,"Length")
+     << " Wavelength: "
+     << std::setw(7) << G4BestUnit(fWavelength,"Length")
      << G4endl;
 }
 
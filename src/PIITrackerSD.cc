@@ -6,6 +6,10 @@
 #include "G4Step.hh"
 #include "G4ThreeVector.hh"
 #include "G4SDManager.hh"
+#include "G4VTouchable.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PhysicalConstants.hh"
 #include "G4ios.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -44,21 +48,27 @@ void PIITrackerSD::Initialize(G4HCofThisEvent* hce)
 G4bool PIITrackerSD::ProcessHits(G4Step* aStep,
                                      G4TouchableHistory*)
 {
-  // energy deposit
-  G4double edep = aStep->GetTotalEnergyDeposit();
+  // Only optical photons are counted; they carry no energy deposit
+  G4Track* track = aStep->GetTrack();
 
-  if (edep==0.) return false;
+  if (track->GetDefinition() != G4OpticalPhoton::OpticalPhotonDefinition())
+    return false;
+
+  G4StepPoint* preStep = aStep->GetPreStepPoint();
 
   PIITrackerHit* newHit = new PIITrackerHit();
 
-  newHit->SetTrackID(aStep->GetTrack()->GetTrackID());
-  newHit->SetPMTNb(aStep->GetPreStepPoint()->GetTouchableHandle()
-                                               ->GetCopyNumber());
-  newHit->SetEdep(edep);
-  newHit->SetPos(aStep->GetPostStepPoint()->GetPosition());
+  newHit->SetTrackID(track->GetTrackID());
+  newHit->SetPMTNb(GetPMTNumber(preStep->GetTouchable()));
+  newHit->SetTime(preStep->GetGlobalTime());
+  newHit->SetPos(preStep->GetPosition());
+  newHit->SetWavelength(h_Planck*c_light/preStep->GetTotalEnergy());
 
   fHitsCollection->insert(newHit);
 
+  // The photon is absorbed by the photocathode
+  track->SetTrackStatus(fStopAndKill);
+
   //newHit->Print();
 
   return true;
@@ -66,6 +76,26 @@ G4bool PIITrackerSD::ProcessHits(G4Step* aStep,
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4int PIITrackerSD::GetPMTNumber(const G4VTouchable* touchable) const
+{
+  // Placed bulbs carry the PMT number as copy number
+  if (touchable->GetHistoryDepth() < 3 || !touchable->GetVolume(1)->IsReplicated())
+    return touchable->GetCopyNumber();
+
+  // Replicated PMT planes: bulb in a column cell, in a row, in a plane
+  EAxis axis;
+  G4int nbOfCols, nbOfRows;
+  G4double width, offset;
+  G4bool consuming;
+  touchable->GetVolume(1)->GetReplicationData(axis, nbOfCols, width, offset, consuming);
+  touchable->GetVolume(2)->GetReplicationData(axis, nbOfRows, width, offset, consuming);
+
+  return (touchable->GetCopyNumber(3)*nbOfRows + touchable->GetCopyNumber(2))*nbOfCols
+         + touchable->GetCopyNumber(1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void PIITrackerSD::EndOfEvent(G4HCofThisEvent*)
 {
   if ( verboseLevel>1 ) {
@@ -0,0 +1,73 @@
+/// \file PIIUniverseMessenger.cc
+/// \brief Implementation of the PIIUniverseMessenger class
+
+#include "PIIUniverseMessenger.hh"
+#include "PIIRunAction.hh"
+#include "PIIUniverseAccumulable.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIUniverseMessenger::PIIUniverseMessenger(PIIRunAction* runner)
+ : fRunAction(runner)
+{
+  fUniverseDirectory = new G4UIdirectory("/PII/universe/");
+  fUniverseDirectory->SetGuidance("Alternate optical parameters tallied in the same run.");
+
+  fAddCmd = new G4UIcommand("/PII/universe/add", this);
+  fAddCmd->SetGuidance("Add a universe of scaled optical parameters.");
+  fAddCmd->SetGuidance("Detected photons are tallied in it with the ratio of the");
+  fAddCmd->SetGuidance("probabilities of their paths there and in the nominal run.");
+  fAddCmd->SetGuidance("Scales apply to the reflector, light guide and tab REFLECTIVITY");
+  fAddCmd->SetGuidance("and to the ScintMat and oil ABSLENGTH. Scales taking a");
+  fAddCmd->SetGuidance("reflectivity above 1 are unphysical. Needs full tracking,");
+  fAddCmd->SetGuidance("/PII/fastsim/scintillator false. Takes effect at the next run.");
+
+  G4UIparameter* parameter = new G4UIparameter("name", 's', false);
+  fAddCmd->SetParameter(parameter);
+
+  const char* scales[5] = { "reflector", "guide", "tab", "scintAbs", "oilAbs" };
+  for (G4int p = 0; p < 5; p++) {
+    parameter = new G4UIparameter(scales[p], 'd', true);
+    parameter->SetDefaultValue(1.);
+    parameter->SetParameterRange((G4String(scales[p]) + " > 0.").c_str());
+    fAddCmd->SetParameter(parameter);
+  }
+  fAddCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fClearCmd = new G4UIcommand("/PII/universe/clear", this);
+  fClearCmd->SetGuidance("Remove all universes.");
+  fClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PIIUniverseMessenger::~PIIUniverseMessenger()
+{
+  delete fAddCmd;
+  delete fClearCmd;
+  delete fUniverseDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PIIUniverseMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fAddCmd) {
+    PIIUniverse universe;
+    std::istringstream values(newValue);
+    values >> universe.name >> universe.reflectorScale >> universe.guideScale
+           >> universe.tabScale >> universe.scintAbsScale >> universe.oilAbsScale;
+    fRunAction->AddUniverse(universe);
+  }
+  else if (command == fClearCmd) {
+    fRunAction->ClearUniverses();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......